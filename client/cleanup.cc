@@ -21,17 +21,19 @@
  */
 
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "dbus/DBusMessage.h"
 #include "dbus/DBusConnection.h"
 #include "snapper/SnapperTmpl.h"
 #include "snapper/Snapper.h"
+#include "snapper/Range.h"
+#include "snapper/timeline.h"
 
-#include "utils/Range.h"
 #include "utils/Limit.h"
-#include "utils/equal-date.h"
 #include "utils/HumanString.h"
 #include "proxy/locker.h"
 #include "cleanup.h"
@@ -43,6 +45,11 @@ namespace snapper
 using namespace std;
 
 
+// Minimal tolerance for the estimate of the freed space, see
+// Cleaner::cleanup_free_space().
+const uint64_t free_estimate_tolerance = 64 * 1024 * 1024;
+
+
 struct Parameters
 {
     Parameters(const ProxySnapper* snapper);
@@ -54,6 +61,11 @@ struct Parameters
     MaxUsedLimit space_limit = 0.5;
     MinFreeLimit free_limit = 0.2;
 
+    // Order in which the candidates are deleted for the quota and free
+    // space conditions, either "age" (oldest first) or "space" (most
+    // exclusive space per snapshot first).
+    string cleanup_order = "age";
+
 
     void read(const ProxyConfig& config, const char* name, time_t& value)
     {
@@ -64,6 +76,21 @@ struct Parameters
     }
 
 
+    void read(const ProxyConfig& config, const char* name, string& value,
+	      const vector<string>& allowed)
+    {
+	const map<string, string>& raw = config.getAllValues();
+	map<string, string>::const_iterator pos = raw.find(name);
+	if (pos != raw.end())
+	{
+	    if (find(allowed.begin(), allowed.end(), pos->second) != allowed.end())
+		value = pos->second;
+	    else
+		cerr << "failed to parse \"" << pos->second << "\" for \"" << name << "\"" << endl;
+	}
+    }
+
+
     template<typename Type>
     void read(const ProxyConfig& config, const char* name, Type& value)
     {
@@ -91,7 +118,8 @@ operator<<(ostream& s, const Parameters& parameters)
 {
     return s << "min-age:" << parameters.min_age << '\n'
 	     << "space-limit:" << parameters.space_limit << '\n'
-	     << "free-limit:" << parameters.free_limit;
+	     << "free-limit:" << parameters.free_limit << '\n'
+	     << "cleanup-order:" << parameters.cleanup_order;
 }
 
 
@@ -101,6 +129,7 @@ Parameters::Parameters(const ProxySnapper* snapper)
 
     read(config, "SPACE_LIMIT", space_limit);
     read(config, "FREE_LIMIT", free_limit);
+    read(config, "CLEANUP_ORDER", cleanup_order, { "age", "space" });
 }
 
 
@@ -113,9 +142,13 @@ public:
 
     virtual ~Cleaner() {}
 
-    void cleanup(Plugins::Report& report);
+    void cleanup(const string& cleanup_algorithm, const CleanupOptions& options,
+		 Plugins::Report& report);
     void cleanup(std::function<bool()> condition, Plugins::Report& report);
 
+    friend void do_cleanup_free_space(const vector<std::pair<ProxySnapper*, string>>& cleanups,
+				      bool verbose, Plugins::Report& report);
+
 protected:
 
     virtual list<ProxySnapshots::iterator> calculate_candidates(ProxySnapshots& snapshots,
@@ -142,19 +175,50 @@ protected:
     // snapshot but which is not included in tmp.
     void filter_pre_post(ProxySnapshots& snapshots, list<ProxySnapshots::iterator>& tmp) const;
 
+    // Returns all snapshots that can be removed for a condition, oldest
+    // first.
+    list<ProxySnapshots::iterator> conditional_candidates();
+
+    // Reads the exclusive space of all snapshots with a cleanup algorithm
+    // at once. Returns false if not available, e.g. without quota.
+    bool read_exclusive(map<unsigned int, uint64_t>& exclusive) const;
+
+    // A single snapshot or a pre and post snapshot that are removed
+    // together.
+    struct Unit
+    {
+	Cleaner* cleaner;
+	list<ProxySnapshots::iterator> members;
+	time_t date;
+	uint64_t exclusive = 0;
+    };
+
+    // Collects the candidates of the cleaners for a condition as units,
+    // oldest first, or with the most exclusive space per snapshot first if
+    // all cleaners use the cleanup order "space". The exclusive spaces are
+    // read once per config if needed for the order or requested, unless
+    // still valid from an earlier call. Returns whether the exclusive
+    // spaces of the units are known.
+    static bool plan_units(const vector<Cleaner*>& cleaners, bool with_exclusive,
+			   vector<Unit>& units);
+
+    // Removes the first n units with one call per config.
+    static void remove_units(const vector<Unit>& units, size_t n, Plugins::Report& report);
+
     void remove(const list<ProxySnapshots::iterator>& tmp, Plugins::Report& report);
 
     // Should the cleanup with quota space be run?
     bool is_quota_aware() const;
 
-    // Is the quota space condition satisfied?
-    bool is_quota_satisfied() const;
+    // Does the cleanup with quota space.
+    void cleanup_quota(Plugins::Report& report);
 
     // Should the cleanup with free space be run?
     bool is_free_aware() const;
 
-    // Is the free space condition satisfied?
-    bool is_free_satisfied() const;
+    // Does the cleanup with free space for several configs on the same
+    // filesystem, see do_cleanup_free_space().
+    static void cleanup_free_space(const vector<Cleaner*>& cleaners, Plugins::Report& report);
 
     void cleanup(ProxySnapshots& snapshots, Plugins::Report& report);
     void cleanup(ProxySnapshots& snapshots, std::function<bool()> condition, Plugins::Report& report);
@@ -166,6 +230,13 @@ protected:
     const bool verbose;
     const Parameters& parameters;
 
+    // Exclusive space of the snapshots used by plan_units().
+    map<unsigned int, uint64_t> exclusive;
+    bool exclusive_valid = false;
+
+    // Whether snapshots were removed since the filesystem was synced.
+    bool free_pending = false;
+
 };
 
 
@@ -244,13 +315,144 @@ Cleaner::filter_pre_post(ProxySnapshots& snapshots, list<ProxySnapshots::iterato
 }
 
 
+list<ProxySnapshots::iterator>
+Cleaner::conditional_candidates()
+{
+    ProxySnapshots& snapshots = snapper->getSnapshots();
+
+    list<ProxySnapshots::iterator> candidates = calculate_candidates(snapshots, Range::MIN);
+
+    filter(snapshots, candidates);
+
+    return candidates;
+}
+
+
+bool
+Cleaner::read_exclusive(map<unsigned int, uint64_t>& exclusive) const
+{
+    exclusive.clear();
+
+    vector<ProxySnapshots::const_iterator> tmp;
+
+    const ProxySnapshots& snapshots = snapper->getSnapshots();
+    for (ProxySnapshots::const_iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+    {
+	if (!it->isCurrent() && !it->getCleanup().empty())
+	    tmp.push_back(it);
+    }
+
+    try
+    {
+	vector<uint64_t> used_spaces = snapper->getUsedSpace(tmp);
+
+	for (size_t i = 0; i < tmp.size(); ++i)
+	    exclusive[tmp[i]->getNum()] = used_spaces[i];
+    }
+    catch (const Exception& e)
+    {
+	SN_CAUGHT(e);
+
+	exclusive.clear();
+	return false;
+    }
+
+    return true;
+}
+
+
+bool
+Cleaner::plan_units(const vector<Cleaner*>& cleaners, bool with_exclusive, vector<Unit>& units)
+{
+    units.clear();
+
+    bool by_space = all_of(cleaners.begin(), cleaners.end(), [](const Cleaner* cleaner) {
+	return cleaner->parameters.cleanup_order == "space";
+    });
+
+    bool known = with_exclusive || by_space;
+
+    for (Cleaner* cleaner : cleaners)
+    {
+	if (known && !cleaner->exclusive_valid)
+	    cleaner->exclusive_valid = cleaner->read_exclusive(cleaner->exclusive);
+
+	known = known && cleaner->exclusive_valid;
+
+	const map<unsigned int, uint64_t>& exclusive = cleaner->exclusive;
+
+	// A post snapshot joins the unit of its pre snapshot.
+
+	map<unsigned int, size_t> pres;
+
+	for (ProxySnapshots::iterator it : cleaner->conditional_candidates())
+	{
+	    size_t i = units.size();
+
+	    if (it->getType() == POST)
+	    {
+		map<unsigned int, size_t>::const_iterator pos = pres.find(it->getPreNum());
+		if (pos != pres.end())
+		    i = pos->second;
+	    }
+
+	    if (i == units.size())
+		units.push_back({ cleaner, {}, it->getDate() });
+
+	    if (it->getType() == PRE)
+		pres[it->getNum()] = i;
+
+	    units[i].members.push_back(it);
+
+	    map<unsigned int, uint64_t>::const_iterator pos = exclusive.find(it->getNum());
+	    if (pos != exclusive.end())
+		units[i].exclusive += pos->second;
+	}
+    }
+
+    stable_sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) {
+	return a.date < b.date;
+    });
+
+    // Without the exclusive space keep the order by age. Ties keep the
+    // order by age.
+
+    if (known && by_space)
+    {
+	stable_sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) {
+	    return (double) a.exclusive / a.members.size() > (double) b.exclusive / b.members.size();
+	});
+    }
+
+    return known;
+}
+
+
 void
-Cleaner::remove(const list<ProxySnapshots::iterator>& tmp, Plugins::Report& report)
+Cleaner::remove_units(const vector<Unit>& units, size_t n, Plugins::Report& report)
 {
-    for (list<ProxySnapshots::iterator>::const_iterator it = tmp.begin(); it != tmp.end(); ++it)
+    map<Cleaner*, list<ProxySnapshots::iterator>> batches;
+
+    for (size_t i = 0; i < n; ++i)
     {
-	snapper->deleteSnapshots({ *it }, verbose, report);
+	list<ProxySnapshots::iterator>& batch = batches[units[i].cleaner];
+	batch.insert(batch.end(), units[i].members.begin(), units[i].members.end());
     }
+
+    for (map<Cleaner*, list<ProxySnapshots::iterator>>::value_type& batch : batches)
+	batch.first->remove(batch.second, report);
+}
+
+
+void
+Cleaner::remove(const list<ProxySnapshots::iterator>& tmp, Plugins::Report& report)
+{
+    if (tmp.empty())
+	return;
+
+    free_pending = true;
+
+    snapper->deleteSnapshots(vector<ProxySnapshots::iterator>(tmp.begin(), tmp.end()), verbose, report);
 }
 
 
@@ -276,23 +478,93 @@ Cleaner::is_quota_aware() const
 }
 
 
-bool
-Cleaner::is_quota_satisfied() const
+void
+Cleaner::cleanup_quota(Plugins::Report& report)
 {
-    QuotaData quota_data = snapper->queryQuotaData();
+    // Querying the quota data requires a quota rescan which can take very
+    // long. So the snapshots needed to satisfy the condition are planned
+    // from the exclusive space of the snapshots and removed at once. Only
+    // then the quota data is queried again.
+
+    while (true)
+    {
+	QuotaData quota_data = snapper->queryQuotaData();
+
+	if (quota_data.size == 0)
+	    return;
+
+	bool satisfied = parameters.space_limit.is_satisfied(quota_data.size, quota_data.used);
+
+#ifdef VERBOSE_LOGGING
+	cout << byte_to_humanstring(quota_data.size, true, 2) << ", "
+	     << byte_to_humanstring(quota_data.used, true, 2) << ", "
+	     << satisfied << '\n';
+#endif
 
-    if (quota_data.size == 0)
-	return true;
+	if (satisfied)
+	{
+#ifdef VERBOSE_LOGGING
+	    cout << "condition satisfied" << '\n';
+#endif
+
+	    return;
+	}
 
-    bool satisfied = parameters.space_limit.is_satisfied(quota_data.size, quota_data.used);
+	exclusive_valid = false;
+
+	vector<Unit> units;
+	bool known = plan_units({ this }, true, units);
+
+	if (units.empty())
+	{
+	    // not enough candidates to satisfy the condition
 
 #ifdef VERBOSE_LOGGING
-    cout << byte_to_humanstring(quota_data.size, true, 2) << ", "
-	 << byte_to_humanstring(quota_data.used, true, 2) << ", "
-	 << satisfied << '\n';
+	    cout << "condition not satisfied" << '\n';
 #endif
 
-    return satisfied;
+	    return;
+	}
+
+	// All snapshots with a cleanup algorithm are in the snapper qgroup
+	// (see Snapper::prepareQuota()) and the exclusive space of the qgroup
+	// is the used space of the quota data. The difference to the sum of
+	// the exclusive spaces of the snapshots is shared between snapshots
+	// of the qgroup. Deleting a set of snapshots frees at least the sum
+	// of their exclusive space and at most additionally the shared space.
+	// Take the fewest units for which even the maximum satisfies the
+	// space limit. Without the exclusive spaces only one unit is removed
+	// per round.
+
+	size_t n = 1;
+
+	if (known)
+	{
+	    uint64_t sum = 0;
+	    for (const map<unsigned int, uint64_t>::value_type& value : exclusive)
+		sum += value.second;
+
+	    const uint64_t used = quota_data.used;
+	    uint64_t freed_max = used - min(used, sum);
+
+	    n = 0;
+	    while (n < units.size())
+	    {
+		freed_max += units[n].exclusive;
+
+		++n;
+
+		if (parameters.space_limit.is_satisfied(quota_data.size, used - min(used, freed_max)))
+		    break;
+	    }
+
+#ifdef VERBOSE_LOGGING
+	    cout << "removing " << n << " of " << units.size() << " units" << '\n';
+#endif
+	}
+
+	remove_units(units, n, report);
+    }
 }
 
 
@@ -318,23 +590,132 @@ Cleaner::is_free_aware() const
 }
 
 
-bool
-Cleaner::is_free_satisfied() const
+void
+Cleaner::cleanup_free_space(const vector<Cleaner*>& cleaners, Plugins::Report& report)
 {
-    FreeSpaceData free_space_data = snapper->queryFreeSpaceData();
+    // On btrfs the space of deleted snapshots is only freed once the
+    // cleaner thread has processed them. So instead of measuring after
+    // every removal the freed space is estimated by the exclusive space of
+    // the snapshots and as many are removed at once as the estimate
+    // requires. Only then the cleaner is waited for and the free space is
+    // measured again.
+
+    // All snappers are on the same filesystem so the free space is
+    // queried only once per round.
 
-    if (free_space_data.size == 0)
-	return true;
+    ProxySnapper* snapper = cleaners.front()->snapper;
 
-    bool satisfied = parameters.free_limit.is_satisfied(free_space_data.size, free_space_data.free);
+    uint64_t free_before = 0;
+    uint64_t estimate = 0;
+
+    while (true)
+    {
+	// Wait until the space of the removed snapshots is actually freed.
+	for (Cleaner* cleaner : cleaners)
+	{
+	    if (cleaner->free_pending)
+	    {
+		cleaner->snapper->syncFilesystem();
+		cleaner->free_pending = false;
+	    }
+	}
+
+	FreeSpaceData free_space_data = snapper->queryFreeSpaceData();
+
+	if (free_space_data.size == 0)
+	    return;
 
 #ifdef VERBOSE_LOGGING
-    cout << byte_to_humanstring(free_space_data.size, true, 2) << ", "
-	 << byte_to_humanstring(free_space_data.free, true, 2) << ", "
-	 << satisfied << '\n';
+	cout << byte_to_humanstring(free_space_data.size, true, 2) << ", "
+	     << byte_to_humanstring(free_space_data.free, true, 2) << '\n';
 #endif
 
-    return satisfied;
+	vector<Cleaner*> unsatisfied;
+
+	for (Cleaner* cleaner : cleaners)
+	{
+	    if (!cleaner->parameters.free_limit.is_satisfied(free_space_data.size, free_space_data.free))
+		unsatisfied.push_back(cleaner);
+	}
+
+	if (unsatisfied.empty())
+	{
+#ifdef VERBOSE_LOGGING
+	    cout << "condition satisfied" << '\n';
+#endif
+
+	    return;
+	}
+
+	if (estimate != 0)
+	{
+	    // Check whether the estimate was good enough to keep the
+	    // exclusive spaces of the remaining snapshots. Deleting snapshots
+	    // can make space exclusive to other snapshots so the estimate is
+	    // usually too low.
+
+	    uint64_t freed = free_space_data.free - min(free_space_data.free, free_before);
+	    uint64_t error = freed > estimate ? freed - estimate : estimate - freed;
+
+	    if (error > max(estimate / 10, free_estimate_tolerance))
+	    {
+#ifdef VERBOSE_LOGGING
+		cout << "estimate off by " << byte_to_humanstring(error, true, 2) << '\n';
+#endif
+
+		for (Cleaner* cleaner : cleaners)
+		    cleaner->exclusive_valid = false;
+	    }
+	}
+
+	// Collect the candidates of all unsatisfied cleaners with pre and post
+	// snapshots kept together.
+
+	vector<Unit> units;
+	bool known = plan_units(unsatisfied, true, units);
+
+	if (units.empty())
+	{
+	    // not enough candidates to satisfy the condition
+
+#ifdef VERBOSE_LOGGING
+	    cout << "condition not satisfied" << '\n';
+#endif
+
+	    return;
+	}
+
+	// Take the fewest units whose estimated exclusive space satisfies
+	// the condition. Without an estimate only one unit is removed per
+	// round.
+
+	size_t n = 1;
+
+	estimate = 0;
+
+	if (known)
+	{
+	    n = 0;
+	    while (n < units.size())
+	    {
+		estimate += units[n].exclusive;
+
+		++n;
+
+		if (all_of(unsatisfied.begin(), unsatisfied.end(), [&free_space_data, estimate](const Cleaner* cleaner) {
+		    return cleaner->parameters.free_limit.is_satisfied(free_space_data.size,
+								       free_space_data.free + estimate);
+		}))
+		    break;
+	    }
+	}
+
+	free_before = free_space_data.free;
+
+	// Remove the snapshots in one batch per config.
+
+	remove_units(units, n, report);
+    }
 }
 
 
@@ -354,8 +735,12 @@ Cleaner::cleanup(ProxySnapshots& snapshots, std::function<bool()> condition, Plu
 {
     while (!condition())
     {
-	list<ProxySnapshots::iterator> candidates = calculate_candidates(snapshots, Range::MIN);
-	if (candidates.empty())
+	exclusive_valid = false;
+
+	vector<Unit> units;
+	plan_units({ this }, false, units);
+
+	if (units.empty())
 	{
 	    // not enough candidates to satisfy the condition
 
@@ -366,36 +751,8 @@ Cleaner::cleanup(ProxySnapshots& snapshots, std::function<bool()> condition, Plu
 	    return;
 	}
 
-	// take more and more candidates into a temporary candidates
-	// list. this is required since the filter will e.g. remove a pre
-	// snapshot candidate if the post snapshot is missing so simply
-	// removing the first candidate is not possible.
-
-	for (list<ProxySnapshots::iterator>::iterator e = candidates.begin(); e != candidates.end(); ++e)
-	{
-	    list<ProxySnapshots::iterator> tmp = list<ProxySnapshots::iterator>(candidates.begin(), next(e));
-
-	    filter(snapshots, tmp);
-
-	    if (!tmp.empty())
-	    {
-		remove(tmp, report);
-
-		// after removing snapshots the condition must be reevaluated
-		break;
-	    }
-
-	    if (next(e) == candidates.end())
-	    {
-		// not enough candidates to satisfy the condition
-
-#ifdef VERBOSE_LOGGING
-		cout << "condition not satisfied" << '\n';
-#endif
-
-		return;
-	    }
-	}
+	// after removing snapshots the condition must be reevaluated
+	remove_units(units, 1, report);
     }
 
 #ifdef VERBOSE_LOGGING
@@ -405,7 +762,8 @@ Cleaner::cleanup(ProxySnapshots& snapshots, std::function<bool()> condition, Plu
 
 
 void
-Cleaner::cleanup(Plugins::Report& report)
+Cleaner::cleanup(const string& cleanup_algorithm, const CleanupOptions& options,
+		 Plugins::Report& report)
 {
     ProxySnapshots& snapshots = snapper->getSnapshots();
 
@@ -413,7 +771,12 @@ Cleaner::cleanup(Plugins::Report& report)
     cout << "cleanup without condition" << '\n';
 #endif
 
-    cleanup(snapshots, report);
+    // The cleanup without condition is done by snapperd if possible. The
+    // cleanups with conditions are always done here since they wait for
+    // quota rescans and the filesystem.
+
+    if (!snapper->cleanup(cleanup_algorithm, {}, verbose, report))
+	cleanup(snapshots, report);
 
     if (is_quota_aware())
     {
@@ -421,7 +784,7 @@ Cleaner::cleanup(Plugins::Report& report)
 	cout << "cleanup with quota condition" << '\n';
 #endif
 
-	cleanup(snapshots, std::bind(&Cleaner::is_quota_satisfied, this), report);
+	cleanup_quota(report);
     }
     else
     {
@@ -430,13 +793,13 @@ Cleaner::cleanup(Plugins::Report& report)
 #endif
     }
 
-    if (is_free_aware())
+    if (options.free_condition && is_free_aware())
     {
 #ifdef VERBOSE_LOGGING
 	cout << "cleanup with free condition" << '\n';
 #endif
 
-	cleanup(snapshots, std::bind(&Cleaner::is_free_satisfied, this), report);
+	cleanup_free_space({ this }, report);
     }
     else
     {
@@ -568,10 +931,18 @@ private:
 
 void
 do_cleanup_number(ProxySnapper* snapper, bool verbose, Plugins::Report& report)
+{
+    do_cleanup_number(snapper, verbose, CleanupOptions(), report);
+}
+
+
+void
+do_cleanup_number(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+		  Plugins::Report& report)
 {
     NumberParameters parameters(snapper);
     NumberCleaner cleaner(snapper, verbose, parameters);
-    cleaner.cleanup(report);
+    cleaner.cleanup("number", options, report);
 }
 
 
@@ -651,85 +1022,6 @@ public:
 
 private:
 
-    bool
-    is_first(list<ProxySnapshots::iterator>::const_iterator first,
-	     list<ProxySnapshots::iterator>::const_iterator last,
-	     ProxySnapshots::const_iterator it1,
-	     std::function<bool(const struct tm& tmp1, const struct tm& tmp2)> pred)
-    {
-	time_t t1 = it1->getDate();
-	struct tm tmp1;
-	localtime_r(&t1, &tmp1);
-
-	for (list<ProxySnapshots::iterator>::const_iterator it2 = first; it2 != last; ++it2)
-	{
-	    if (it1 == *it2)
-		continue;
-
-	    time_t t2 = (*it2)->getDate();
-	    struct tm tmp2;
-	    localtime_r(&t2, &tmp2);
-
-	    if (!pred(tmp1, tmp2))
-		return true;
-
-	    if (t1 > t2)
-		return false;
-	}
-
-	return true;
-    }
-
-
-    bool
-    is_first_yearly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_year);
-    }
-
-    bool
-    is_first_quarterly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_quarter);
-    }
-
-    bool
-    is_first_monthly(list<ProxySnapshots::iterator>::const_iterator first,
-		     list<ProxySnapshots::iterator>::const_iterator last,
-		     ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_month);
-    }
-
-    bool
-    is_first_weekly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_week);
-    }
-
-    bool
-    is_first_daily(list<ProxySnapshots::iterator>::const_iterator first,
-		   list<ProxySnapshots::iterator>::const_iterator last,
-		   ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_day);
-    }
-
-    bool
-    is_first_hourly(list<ProxySnapshots::iterator>::const_iterator first,
-		    list<ProxySnapshots::iterator>::const_iterator last,
-		    ProxySnapshots::const_iterator it1)
-    {
-	return is_first(first, last, it1, equal_hour);
-    }
-
-
     list<ProxySnapshots::iterator>
     calculate_candidates(ProxySnapshots& snapshots, const Range::Value& value) override
     {
@@ -743,50 +1035,26 @@ private:
 		ret.push_front(it);
 	}
 
-	size_t num_hourly = 0;
-	size_t num_daily = 0;
-	size_t num_weekly = 0;
-	size_t num_monthly = 0;
-	size_t num_quarterly = 0;
-	size_t num_yearly = 0;
+	vector<TimelineEntry> entries;
+	entries.reserve(ret.size());
 
-	list<ProxySnapshots::iterator>::iterator it = ret.begin();
-	while (it != ret.end())
-	{
-	    bool keep = false;
+	for (const ProxySnapshots::iterator& it : ret)
+	    entries.push_back(timeline_entry(*it));
 
-	    if (num_hourly < parameters.limit_hourly.value(value) && is_first_hourly(it, ret.end(), *it))
-	    {
-		++num_hourly;
-		keep = true;
-	    }
-	    if (num_daily < parameters.limit_daily.value(value) && is_first_daily(it, ret.end(), *it))
-	    {
-		++num_daily;
-		keep = true;
-	    }
-	    if (num_weekly < parameters.limit_weekly.value(value) && is_first_weekly(it, ret.end(), *it))
-	    {
-		++num_weekly;
-		keep = true;
-	    }
-	    if (num_monthly < parameters.limit_monthly.value(value) && is_first_monthly(it, ret.end(), *it))
-	    {
-		++num_monthly;
-		keep = true;
-	    }
-	    if (num_quarterly < parameters.limit_quarterly.value(value) && is_first_quarterly(it, ret.end(), *it))
-	    {
-		++num_quarterly;
-		keep = true;
-	    }
-	    if (num_yearly < parameters.limit_yearly.value(value) && is_first_yearly(it, ret.end(), *it))
-	    {
-		++num_yearly;
-		keep = true;
-	    }
+	TimelineLimits limits;
+	limits.hourly = parameters.limit_hourly.value(value);
+	limits.daily = parameters.limit_daily.value(value);
+	limits.weekly = parameters.limit_weekly.value(value);
+	limits.monthly = parameters.limit_monthly.value(value);
+	limits.quarterly = parameters.limit_quarterly.value(value);
+	limits.yearly = parameters.limit_yearly.value(value);
 
-	    if (keep)
+	vector<bool> keep = timeline_keep(entries, limits);
+
+	size_t i = 0;
+	for (list<ProxySnapshots::iterator>::iterator it = ret.begin(); it != ret.end(); ++i)
+	{
+	    if (keep[i])
 		it = ret.erase(it);
 	    else
 		++it;
@@ -796,15 +1064,46 @@ private:
 
 	return ret;
     }
+
+
+    // The broken-down dates are cached since calculate_candidates() is called
+    // again after every removal when cleaning up with a condition.
+
+    TimelineEntry
+    timeline_entry(const ProxySnapshot& snapshot)
+    {
+	map<unsigned int, TimelineEntry>::iterator pos = cache.find(snapshot.getNum());
+	if (pos != cache.end() && pos->second.date == snapshot.getDate())
+	    return pos->second;
+
+	TimelineEntry entry;
+	entry.date = snapshot.getDate();
+	localtime_r(&entry.date, &entry.tm);
+
+	cache[snapshot.getNum()] = entry;
+
+	return entry;
+    }
+
+    map<unsigned int, TimelineEntry> cache;
+
 };
 
 
 void
 do_cleanup_timeline(ProxySnapper* snapper, bool verbose, Plugins::Report& report)
+{
+    do_cleanup_timeline(snapper, verbose, CleanupOptions(), report);
+}
+
+
+void
+do_cleanup_timeline(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+		    Plugins::Report& report)
 {
     TimelineParameters parameters(snapper);
     TimelineCleaner cleaner(snapper, verbose, parameters);
-    cleaner.cleanup(report);
+    cleaner.cleanup("timeline", options, report);
 }
 
 
@@ -851,20 +1150,29 @@ private:
     {
 	list<ProxySnapshots::iterator> ret;
 
+	vector<pair<ProxySnapshots::iterator, ProxySnapshots::iterator>> pairs;
+
 	for (ProxySnapshots::iterator it1 = snapshots.begin(); it1 != snapshots.end(); ++it1)
 	{
 	    if (it1->getType() == PRE)
 	    {
 		ProxySnapshots::iterator it2 = snapshots.findPost(it1);
 		if (it2 != snapshots.end())
-		{
-		    ProxyComparison comparison = snapper->createComparison(*it1, *it2, false);
-		    if (comparison.getFiles().empty())
-		    {
-			ret.push_back(it1);
-			ret.push_back(it2);
-		    }
-		}
+		    pairs.emplace_back(it1, it2);
+	    }
+	}
+
+	// Check all pairs in one call.
+
+	vector<bool> empty = snapper->isComparisonEmpty(vector<pair<ProxySnapshots::const_iterator,
+							ProxySnapshots::const_iterator>>(pairs.begin(), pairs.end()));
+
+	for (size_t i = 0; i < pairs.size(); ++i)
+	{
+	    if (empty[i])
+	    {
+		ret.push_back(pairs[i].first);
+		ret.push_back(pairs[i].second);
 	    }
 	}
 
@@ -875,10 +1183,18 @@ private:
 
 void
 do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, Plugins::Report& report)
+{
+    do_cleanup_empty_pre_post(snapper, verbose, CleanupOptions(), report);
+}
+
+
+void
+do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+			  Plugins::Report& report)
 {
     EmptyPrePostParameters parameters(snapper);
     EmptyPrePostCleaner cleaner(snapper, verbose, parameters);
-    cleaner.cleanup(report);
+    cleaner.cleanup("empty-pre-post", options, report);
 }
 
 
@@ -891,4 +1207,64 @@ do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, std::function<boo
     cleaner.cleanup(condition, report);
 }
 
+
+static std::unique_ptr<Cleaner>
+make_cleaner(ProxySnapper* snapper, bool verbose, const string& cleanup_algorithm,
+	     std::unique_ptr<Parameters>& parameters)
+{
+    if (cleanup_algorithm == "number")
+    {
+	NumberParameters* tmp = new NumberParameters(snapper);
+	parameters.reset(tmp);
+	return std::unique_ptr<Cleaner>(new NumberCleaner(snapper, verbose, *tmp));
+    }
+
+    if (cleanup_algorithm == "timeline")
+    {
+	TimelineParameters* tmp = new TimelineParameters(snapper);
+	parameters.reset(tmp);
+	return std::unique_ptr<Cleaner>(new TimelineCleaner(snapper, verbose, *tmp));
+    }
+
+    if (cleanup_algorithm == "empty-pre-post")
+    {
+	EmptyPrePostParameters* tmp = new EmptyPrePostParameters(snapper);
+	parameters.reset(tmp);
+	return std::unique_ptr<Cleaner>(new EmptyPrePostCleaner(snapper, verbose, *tmp));
+    }
+
+    SN_THROW(Exception("unknown cleanup algorithm"));
+    __builtin_unreachable();
+}
+
+
+void
+do_cleanup_free_space(const vector<std::pair<ProxySnapper*, string>>& cleanups, bool verbose,
+		      Plugins::Report& report)
+{
+    vector<std::unique_ptr<Parameters>> parameters;
+    vector<std::unique_ptr<Cleaner>> cleaners;
+
+    for (const pair<ProxySnapper*, string>& cleanup : cleanups)
+    {
+	std::unique_ptr<Parameters> tmp;
+	std::unique_ptr<Cleaner> cleaner = make_cleaner(cleanup.first, verbose, cleanup.second, tmp);
+
+	if (!cleaner->is_free_aware())
+	    continue;
+
+	parameters.push_back(std::move(tmp));
+	cleaners.push_back(std::move(cleaner));
+    }
+
+    if (cleaners.empty())
+	return;
+
+    vector<Cleaner*> tmp;
+    for (const std::unique_ptr<Cleaner>& cleaner : cleaners)
+	tmp.push_back(cleaner.get());
+
+    Cleaner::cleanup_free_space(tmp, report);
+}
+
 }
@@ -22,6 +22,9 @@
 
 
 #include <functional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "proxy/proxy.h"
 
@@ -29,9 +32,20 @@
 namespace snapper
 {
 
+struct CleanupOptions
+{
+    /*
+     * Whether the cleanup based on free space is done. For several configs on the same
+     * filesystem it can be done once for all configs with do_cleanup_free_space().
+     */
+    bool free_condition = true;
+};
+
+
 /*
  * The following three functions do the cleanup based on the conditionals defined in the
- * config, that are hard limit, quota and free space.
+ * config, that are hard limit, quota and free space. If possible the cleanup based on the
+ * hard limit is done by snapperd.
  */
 
 void
@@ -44,6 +58,19 @@ void
 do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, Plugins::Report& report);
 
 
+void
+do_cleanup_number(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+		  Plugins::Report& report);
+
+void
+do_cleanup_timeline(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+		    Plugins::Report& report);
+
+void
+do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, const CleanupOptions& options,
+			  Plugins::Report& report);
+
+
 /*
  * The following three functions do the cleanup only based on the provided
  * conditional. The lower range and min-age defined in the config are respected.
@@ -61,4 +88,18 @@ void
 do_cleanup_empty_pre_post(ProxySnapper* snapper, bool verbose, std::function<bool()> condition,
 			  Plugins::Report& report);
 
+
+/*
+ * Does the cleanup based on free space once for several configs on the same filesystem.
+ * The pairs consist of a config and a cleanup algorithm ("number", "timeline" or
+ * "empty-pre-post"). The candidates of all pairs are removed oldest first, or with the
+ * most exclusive space first if all pairs use the cleanup order "space". As few
+ * candidates as possible are removed based on their exclusive space, in one batch per
+ * config, before the free space is measured again.
+ */
+
+void
+do_cleanup_free_space(const std::vector<std::pair<ProxySnapper*, std::string>>& cleanups,
+		      bool verbose, Plugins::Report& report);
+
 }
@@ -250,7 +250,7 @@ step5(const string& root_prefix, const string& snapshot_type, unsigned int pre_n
         } else if (snapshot_type == "pre") {
             snapshot = snapper.createPreSnapshot(scd, report);
         } else if (snapshot_type == "post") {
-            Snapshots snapshots = snapper.getSnapshots();
+            Snapshots& snapshots = snapper.getSnapshots();
             Snapshots::iterator pre = snapshots.find(pre_num);
             snapshot = snapper.createPostSnapshot(pre, scd, report);
         }
@@ -187,6 +187,27 @@ command_create_single_snapshot(DBus::Connection& conn, const string& config_name
 }
 
 
+vector<unsigned int>
+command_create_single_snapshots(DBus::Connection& conn, const vector<string>& config_names,
+				const string& description, const string& cleanup,
+				const map<string, string>& userdata)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "CreateSingleSnapshots");
+
+    DBus::Marshaller marshaller(call);
+    marshaller << config_names << description << cleanup << userdata;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<unsigned int> numbers;
+
+    DBus::Unmarshaller unmarshaller(reply);
+    unmarshaller >> numbers;
+
+    return numbers;
+}
+
+
 unsigned int
 command_create_single_snapshot_v2(DBus::Connection& conn, const string& config_name,
 				  unsigned int parent_num, bool read_only,
@@ -300,6 +321,40 @@ command_delete_snapshots(DBus::Connection& conn, const string& config_name,
 }
 
 
+vector<unsigned int>
+command_cleanup(DBus::Connection& conn, const string& config_name, const string& cleanup_algorithm,
+		const map<string, string>& options, bool verbose)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "Cleanup");
+
+    DBus::Marshaller marshaller(call);
+    marshaller << config_name << cleanup_algorithm << options;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<unsigned int> nums;
+
+    DBus::Unmarshaller unmarshaller(reply);
+    unmarshaller >> nums;
+
+    if (verbose && !nums.empty())
+    {
+	cout << sformat(_("Deleting snapshot from %s:", "Deleting snapshots from %s:", nums.size()),
+			config_name.c_str()) << endl;
+
+	for (vector<unsigned int>::const_iterator it = nums.begin(); it != nums.end(); ++it)
+	{
+	    if (it != nums.begin())
+		cout << ", ";
+	    cout << *it;
+	}
+	cout << endl;
+    }
+
+    return nums;
+}
+
+
 bool
 command_is_snapshot_read_only(DBus::Connection& conn, const string& config_name, unsigned int num)
 {
@@ -438,6 +493,26 @@ command_get_used_space(DBus::Connection& conn, const string& config_name, unsign
 }
 
 
+vector<uint64_t>
+command_get_used_spaces(DBus::Connection& conn, const string& config_name,
+			const vector<unsigned int>& nums)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "GetUsedSpaces");
+
+    DBus::Marshaller marshaller(call);
+    marshaller << config_name << nums;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<dbus_uint64_t> used_spaces;
+
+    DBus::Unmarshaller unmarshaller(reply);
+    unmarshaller >> used_spaces;
+
+    return vector<uint64_t>(used_spaces.begin(), used_spaces.end());
+}
+
+
 string
 command_mount_snapshot(DBus::Connection& conn, const string& config_name,
 		       unsigned int num, bool user_request)
@@ -503,6 +578,26 @@ command_create_comparison(DBus::Connection& conn, const string& config_name, uns
 }
 
 
+vector<bool>
+command_is_comparison_empty(DBus::Connection& conn, const string& config_name,
+			    const vector<unsigned int>& numbers1, const vector<unsigned int>& numbers2)
+{
+    DBus::MessageMethodCall call(SERVICE, OBJECT, INTERFACE, "IsComparisonEmpty");
+
+    DBus::Marshaller marshaller(call);
+    marshaller << config_name << numbers1 << numbers2;
+
+    DBus::Message reply = conn.send_with_reply_and_block(call);
+
+    vector<bool> ret;
+
+    DBus::Unmarshaller unmarshaller(reply);
+    unmarshaller >> ret;
+
+    return ret;
+}
+
+
 void
 command_delete_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2)
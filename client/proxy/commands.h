@@ -59,6 +59,11 @@ command_create_single_snapshot(DBus::Connection& conn, const string& config_name
 			       const string& description, const string& cleanup,
 			       const map<string, string>& userdata);
 
+vector<unsigned int>
+command_create_single_snapshots(DBus::Connection& conn, const vector<string>& config_names,
+				const string& description, const string& cleanup,
+				const map<string, string>& userdata);
+
 unsigned int
 command_create_single_snapshot_v2(DBus::Connection& conn, const string& config_name,
 				  unsigned int parent_num, bool read_only,
@@ -85,6 +90,10 @@ void
 command_delete_snapshots(DBus::Connection& conn, const string& config_name,
 			 const vector<unsigned int>& nums, bool verbose);
 
+vector<unsigned int>
+command_cleanup(DBus::Connection& conn, const string& config_name, const string& cleanup_algorithm,
+		const map<string, string>& options, bool verbose);
+
 bool
 command_is_snapshot_read_only(DBus::Connection& conn, const string& config_name, unsigned int num);
 
@@ -104,6 +113,10 @@ command_calculate_used_space(DBus::Connection& conn, const string& config_name);
 uint64_t
 command_get_used_space(DBus::Connection& conn, const string& config_name, unsigned int num);
 
+vector<uint64_t>
+command_get_used_spaces(DBus::Connection& conn, const string& config_name,
+			const vector<unsigned int>& nums);
+
 string
 command_mount_snapshot(DBus::Connection& conn, const string& config_name,
 		       unsigned int num, bool user_request);
@@ -120,6 +133,10 @@ void
 command_create_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2);
 
+vector<bool>
+command_is_comparison_empty(DBus::Connection& conn, const string& config_name,
+			    const vector<unsigned int>& numbers1, const vector<unsigned int>& numbers2);
+
 void
 command_delete_comparison(DBus::Connection& conn, const string& config_name, unsigned int number1,
 			  unsigned int number2);
@@ -21,6 +21,7 @@
 
 
 #include <cstring>
+#include <snapper/LoggerImpl.h>
 
 #include "proxy-dbus.h"
 #include "commands.h"
@@ -86,6 +87,39 @@ ProxySnapshotDbus::getUsedSpace() const
 }
 
 
+vector<uint64_t>
+ProxySnapperDbus::getUsedSpace(const vector<ProxySnapshots::const_iterator>& snapshots) const
+{
+    if (snapshots.empty())
+	return {};
+
+    vector<unsigned int> nums;
+
+    for (const ProxySnapshots::const_iterator& snapshot : snapshots)
+	nums.push_back(snapshot->getNum());
+
+    try
+    {
+	return command_get_used_spaces(conn(), config_name, nums);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// older snapperd without the GetUsedSpaces method
+	if (strcmp(e.name(), "error.unknown_method") != 0)
+	    SN_RETHROW(e);
+    }
+
+    vector<uint64_t> ret;
+
+    for (const ProxySnapshots::const_iterator& snapshot : snapshots)
+	ret.push_back(snapshot->getUsedSpace());
+
+    return ret;
+}
+
+
 void
 ProxySnapperDbus::lock_config() const
 {
@@ -100,6 +134,38 @@ ProxySnapperDbus::unlock_config() const
 }
 
 
+bool
+ProxySnapperDbus::cleanup(const string& cleanup_algorithm, const map<string, string>& options,
+			  bool verbose, Plugins::Report& report)
+{
+    vector<unsigned int> nums;
+
+    try
+    {
+	nums = command_cleanup(conn(), config_name, cleanup_algorithm, options, verbose);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// older snapperd without the Cleanup method
+	if (strcmp(e.name(), "error.unknown_method") == 0)
+	    return false;
+
+	SN_RETHROW(e);
+    }
+
+    for (unsigned int num : nums)
+    {
+	ProxySnapshots::iterator it = proxy_snapshots.find(num);
+	if (it != proxy_snapshots.end())
+	    proxy_snapshots.erase(it);
+    }
+
+    return true;
+}
+
+
 string
 ProxySnapshotDbus::mountFilesystemSnapshot(bool user_request) const
 {
@@ -324,6 +390,47 @@ ProxySnapperDbus::createComparison(const ProxySnapshot& lhs, const ProxySnapshot
 }
 
 
+vector<bool>
+ProxySnapperDbus::isComparisonEmpty(const vector<pair<ProxySnapshots::const_iterator,
+				    ProxySnapshots::const_iterator>>& pairs)
+{
+    if (pairs.empty())
+	return {};
+
+    vector<unsigned int> numbers1;
+    vector<unsigned int> numbers2;
+
+    for (const pair<ProxySnapshots::const_iterator, ProxySnapshots::const_iterator>& tmp : pairs)
+    {
+	numbers1.push_back(tmp.first->getNum());
+	numbers2.push_back(tmp.second->getNum());
+    }
+
+    try
+    {
+	return command_is_comparison_empty(conn(), config_name, numbers1, numbers2);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// older snapperd without the IsComparisonEmpty method
+	if (strcmp(e.name(), "error.unknown_method") != 0)
+	    SN_RETHROW(e);
+    }
+
+    vector<bool> ret;
+
+    for (const pair<ProxySnapshots::const_iterator, ProxySnapshots::const_iterator>& tmp : pairs)
+    {
+	ProxyComparison comparison = createComparison(*tmp.first, *tmp.second, false);
+	ret.push_back(comparison.getFiles().empty());
+    }
+
+    return ret;
+}
+
+
 void
 ProxySnapperDbus::syncFilesystem() const
 {
@@ -381,6 +488,68 @@ ProxySnappersDbus::getConfigs() const
 }
 
 
+vector<unsigned int>
+ProxySnappersDbus::createSingleSnapshots(const vector<string>& config_names, const SCD& scd,
+					 Plugins::Report& report)
+{
+    vector<unsigned int> nums;
+
+    try
+    {
+	nums = command_create_single_snapshots(conn, config_names, scd.description, scd.cleanup,
+					       scd.userdata);
+    }
+    catch (const DBus::ErrorException& e)
+    {
+	SN_CAUGHT(e);
+
+	// If snapper was just updated and the old snapperd is still running it might not
+	// know the CreateSingleSnapshots method.
+
+	if (strcmp(e.name(), "error.unknown_method") != 0)
+	    SN_RETHROW(e);
+
+	nums.clear();
+
+	for (const string& config_name : config_names)
+	{
+	    try
+	    {
+		nums.push_back(getSnapper(config_name)->createSingleSnapshot(scd, report)->getNum());
+	    }
+	    catch (const DBus::ErrorException& e)
+	    {
+		SN_CAUGHT(e);
+
+		y2err("creating snapshot for '" << config_name << "' failed, " << e.name() << ", "
+		      << e.message());
+
+		nums.push_back(0);
+	    }
+	}
+
+	return nums;
+    }
+
+    // Keep the snapshot lists of already loaded configs up to date.
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	if (nums[i] == 0)
+	    continue;
+
+	for (unique_ptr<ProxySnapperDbus>& proxy_snapper : proxy_snappers)
+	{
+	    if (proxy_snapper->config_name == config_names[i])
+		proxy_snapper->proxy_snapshots.emplace_back(new ProxySnapshotDbus(&proxy_snapper->proxy_snapshots,
+										  nums[i]));
+	}
+    }
+
+    return nums;
+}
+
+
 Plugins::Report
 ProxySnappersDbus::get_plugins_report() const
 {
@@ -143,6 +143,9 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) override;
 
+    virtual vector<bool> isComparisonEmpty(const vector<std::pair<ProxySnapshots::const_iterator,
+					   ProxySnapshots::const_iterator>>& pairs) override;
+
     virtual void syncFilesystem() const override;
 
     virtual ProxySnapshots& getSnapshots() override { return proxy_snapshots; }
@@ -158,9 +161,14 @@ public:
 
     virtual void calculateUsedSpace() const override;
 
+    virtual vector<uint64_t> getUsedSpace(const vector<ProxySnapshots::const_iterator>& snapshots) const override;
+
     virtual void lock_config() const override;
     virtual void unlock_config() const override;
 
+    virtual bool cleanup(const string& cleanup_algorithm, const map<string, string>& options,
+			 bool verbose, Plugins::Report& report) override;
+
     DBus::Connection& conn() const;
 
 private:
@@ -194,6 +202,9 @@ public:
 
     virtual map<string, ProxyConfig> getConfigs() const override;
 
+    virtual vector<unsigned int> createSingleSnapshots(const vector<string>& config_names,
+						       const SCD& scd, Plugins::Report& report) override;
+
     virtual Plugins::Report get_plugins_report() const override;
 
     virtual vector<string> debug() const override;
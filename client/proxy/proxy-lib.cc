@@ -20,6 +20,8 @@
  */
 
 
+#include <snapper/LoggerImpl.h>
+
 #include "proxy-lib.h"
 
 
@@ -90,7 +92,14 @@ ProxySnapperLib::setConfig(const ProxyConfig& proxy_config)
 ProxySnapshots::const_iterator
 ProxySnapperLib::createSingleSnapshot(const SCD& scd, Plugins::Report& report)
 {
-    proxy_snapshots.emplace_back(new ProxySnapshotLib(snapper->createSingleSnapshot(scd, report)));
+    return addSnapshot(snapper->createSingleSnapshot(scd, report));
+}
+
+
+ProxySnapshots::const_iterator
+ProxySnapperLib::addSnapshot(Snapshots::iterator snapshot)
+{
+    proxy_snapshots.emplace_back(new ProxySnapshotLib(snapshot));
 
     return prev(proxy_snapshots.end());
 }
@@ -142,8 +151,11 @@ ProxySnapperLib::modifySnapshot(ProxySnapshots::iterator snapshot, const SMD& sm
 void
 ProxySnapperLib::deleteSnapshots(vector<ProxySnapshots::iterator> snapshots, bool verbose, Plugins::Report& report)
 {
+    vector<Snapshots::iterator> tmp;
     for (ProxySnapshots::iterator& snapshot : snapshots)
-	snapper->deleteSnapshot(to_lib(*snapshot).it, report);
+	tmp.push_back(to_lib(*snapshot).it);
+
+    snapper->deleteSnapshots(tmp, report);
 
     ProxySnapshots& proxy_snapshots = getSnapshots();
     for (ProxySnapshots::iterator& proxy_snapshot : snapshots)
@@ -158,6 +170,31 @@ ProxySnapperLib::createComparison(const ProxySnapshot& lhs, const ProxySnapshot&
 }
 
 
+vector<bool>
+ProxySnapperLib::isComparisonEmpty(const vector<pair<ProxySnapshots::const_iterator,
+				   ProxySnapshots::const_iterator>>& pairs)
+{
+    vector<bool> ret;
+
+    for (const pair<ProxySnapshots::const_iterator, ProxySnapshots::const_iterator>& tmp : pairs)
+	ret.push_back(Comparison::isEmpty(snapper.get(), to_lib(*tmp.first).it, to_lib(*tmp.second).it));
+
+    return ret;
+}
+
+
+vector<uint64_t>
+ProxySnapperLib::getUsedSpace(const vector<ProxySnapshots::const_iterator>& snapshots) const
+{
+    vector<uint64_t> ret;
+
+    for (const ProxySnapshots::const_iterator& snapshot : snapshots)
+	ret.push_back(snapshot->getUsedSpace());
+
+    return ret;
+}
+
+
 ProxySnapshotsLib::ProxySnapshotsLib(ProxySnapperLib* backref)
     : backref(backref)
 {
@@ -210,6 +247,48 @@ ProxySnappersLib::getConfigs() const
 }
 
 
+vector<unsigned int>
+ProxySnappersLib::createSingleSnapshots(const vector<string>& config_names, const SCD& scd,
+					Plugins::Report& report)
+{
+    // A config that cannot be loaded must not prevent the snapshots of the
+    // other configs.
+
+    vector<unsigned int> nums(config_names.size(), 0);
+
+    vector<size_t> indices;
+    vector<ProxySnapperLib*> proxy_snappers;
+    vector<Snapper*> snappers;
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	try
+	{
+	    ProxySnapperLib* proxy_snapper = dynamic_cast<ProxySnapperLib*>(getSnapper(config_names[i]));
+	    proxy_snappers.push_back(proxy_snapper);
+	    snappers.push_back(proxy_snapper->snapper.get());
+	    indices.push_back(i);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2err("creating snapshot for '" << config_names[i] << "' failed, " << e.what());
+	}
+    }
+
+    vector<Snapshots::iterator> snapshots = Snapper::createSingleSnapshots(snappers, scd, report);
+
+    for (size_t i = 0; i < snappers.size(); ++i)
+    {
+	if (snapshots[i] != snappers[i]->getSnapshots().end())
+	    nums[indices[i]] = proxy_snappers[i]->addSnapshot(snapshots[i])->getNum();
+    }
+
+    return nums;
+}
+
+
 ProxyComparisonLib::ProxyComparisonLib(ProxySnapperLib* proxy_snapper, const ProxySnapshot& lhs,
 				       const ProxySnapshot& rhs, bool mount)
     : proxy_snapper(proxy_snapper)
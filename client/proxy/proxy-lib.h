@@ -126,6 +126,9 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) override;
 
+    virtual vector<bool> isComparisonEmpty(const vector<std::pair<ProxySnapshots::const_iterator,
+					   ProxySnapshots::const_iterator>>& pairs) override;
+
     virtual void syncFilesystem() const override { snapper->syncFilesystem(); }
 
     virtual ProxySnapshots& getSnapshots() override { return proxy_snapshots; }
@@ -141,9 +144,21 @@ public:
 
     virtual void calculateUsedSpace() const override { snapper->calculateUsedSpace(); }
 
+    virtual vector<uint64_t> getUsedSpace(const vector<ProxySnapshots::const_iterator>& snapshots) const override;
+
     virtual void lock_config() const override {}
     virtual void unlock_config() const override {}
 
+    virtual bool cleanup(const string&, const map<string, string>&, bool, Plugins::Report&) override
+    {
+	return false;
+    }
+
+    /**
+     * Add a snapshot created directly with the Snapper object.
+     */
+    ProxySnapshots::const_iterator addSnapshot(Snapshots::iterator snapshot);
+
     std::unique_ptr<Snapper> snapper;
 
 private:
@@ -171,6 +186,9 @@ public:
 
     virtual map<string, ProxyConfig> getConfigs() const override;
 
+    virtual vector<unsigned int> createSingleSnapshots(const vector<string>& config_names,
+						       const SCD& scd, Plugins::Report& report) override;
+
     virtual Plugins::Report get_plugins_report() const override { return {}; }
 
     virtual vector<string> debug() const override { return Snapper::debug(); }
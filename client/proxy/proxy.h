@@ -239,6 +239,13 @@ public:
     virtual ProxyComparison createComparison(const ProxySnapshot& lhs, const ProxySnapshot& rhs,
 					     bool mount) = 0;
 
+    /**
+     * Check for every pair of snapshots whether the comparison is empty. Cheaper
+     * than creating the comparisons since comparing stops at the first difference.
+     */
+    virtual vector<bool> isComparisonEmpty(const vector<std::pair<ProxySnapshots::const_iterator,
+					   ProxySnapshots::const_iterator>>& pairs) = 0;
+
     virtual void syncFilesystem() const = 0;
 
     virtual ProxySnapshots& getSnapshots() = 0;
@@ -254,9 +261,25 @@ public:
 
     virtual void calculateUsedSpace() const = 0;
 
+    /**
+     * Get the used (exclusive) space of several snapshots at once. Cheaper than
+     * ProxySnapshot::getUsedSpace() for every snapshot with D-Bus.
+     */
+    virtual vector<uint64_t> getUsedSpace(const vector<ProxySnapshots::const_iterator>& snapshots) const = 0;
+
     virtual void lock_config() const = 0;
     virtual void unlock_config() const = 0;
 
+    /**
+     * Run the cleanup algorithm (number, timeline or empty-pre-post) based on
+     * the limits, without any conditional, in snapperd. Returns false if that
+     * is not possible, e.g. when not using D-Bus or with an older snapperd,
+     * and the caller has to do the cleanup. The options are passed to the
+     * Cleanup method of snapperd.
+     */
+    virtual bool cleanup(const string& cleanup_algorithm, const map<string, string>& options,
+			 bool verbose, Plugins::Report& report) = 0;
+
 };
 
 
@@ -281,6 +304,15 @@ public:
     map<string, ProxyConfig> getConfigs() const
 	{ return impl->getConfigs(); }
 
+    /**
+     * Create a single snapshot for each of the configs at once. Returns
+     * the number of the new snapshot for each config or 0 if creating
+     * that snapshot failed.
+     */
+    vector<unsigned int> createSingleSnapshots(const vector<string>& config_names, const SCD& scd,
+					       Plugins::Report& report)
+	{ return impl->createSingleSnapshots(config_names, scd, report); }
+
     /**
      * This function needs a few works: The Snapper class does not have a Plugin::Report
      * object. The individual functions of the Snapper class have. For for proxy-lib this
@@ -311,6 +343,9 @@ public:
 
 	virtual map<string, ProxyConfig> getConfigs() const = 0;
 
+	virtual vector<unsigned int> createSingleSnapshots(const vector<string>& config_names,
+							   const SCD& scd, Plugins::Report& report) = 0;
+
 	virtual Plugins::Report get_plugins_report() const = 0;
 
 	virtual vector<string> debug() const = 0;
@@ -25,6 +25,8 @@
 #include <snapper/SnapperDefines.h>
 #include <snapper/AppUtil.h>
 
+#include "../utils/HumanString.h"
+
 #include "BackupConfig.h"
 #include "JsonFile.h"
 
@@ -37,6 +39,8 @@ namespace snapper
 
     const vector<string> EnumInfo<BackupConfig::TargetMode>::names({ "local", "ssh-push" });
 
+    const vector<string> EnumInfo<BackupConfig::Compression>::names({ "none", "zstd" });
+
 
     BackupConfig::BackupConfig(const string& name)
 	: name(name)
@@ -71,12 +75,47 @@ namespace snapper
 	get_child_nodes(json_file.get_root(), "send-options", send_options);
 	get_child_nodes(json_file.get_root(), "receive-options", receive_options);
 
+	string tmp2;
+	if (get_child_value(json_file.get_root(), "transfer-rate-limit", tmp2))
+	{
+	    try
+	    {
+		transfer_rate_limit = humanstring_to_byte(tmp2, true);
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+
+		SN_THROW(Exception(sformat("invalid transfer-rate-limit '%s' in '%s'", tmp2.c_str(),
+					   name.c_str())));
+	    }
+	}
+
+	get_child_value(json_file.get_root(), "resumable-transfers", resumable_transfers);
+
+	string tmp3;
+	if (get_child_value(json_file.get_root(), "compression", tmp3))
+	{
+	    if (!toValue(tmp3, compression, false))
+		SN_THROW(Exception(sformat("unknown compression '%s' in '%s'", tmp3.c_str(), name.c_str())));
+	}
+
+	get_child_value(json_file.get_root(), "compression-level", compression_level);
+	if (compression_level > 19)
+	    SN_THROW(Exception(sformat("invalid compression-level in '%s'", name.c_str())));
+
+	get_child_value(json_file.get_root(), "compression-threads", compression_threads);
+
+	get_child_value(json_file.get_root(), "state-cache", state_cache);
+	get_child_value(json_file.get_root(), "state-cache-max-age", state_cache_max_age);
+
 	get_child_value(json_file.get_root(), "target-btrfs-bin", target_btrfs_bin);
 	get_child_value(json_file.get_root(), "target-ls-bin", target_ls_bin);
 	get_child_value(json_file.get_root(), "target-mkdir-bin", target_mkdir_bin);
 	get_child_value(json_file.get_root(), "target-rm-bin", target_rm_bin);
 	get_child_value(json_file.get_root(), "target-rmdir-bin", target_rmdir_bin);
 	get_child_value(json_file.get_root(), "target-sha256sum-bin", target_sha256sum_bin);
+	get_child_value(json_file.get_root(), "target-zstd-bin", target_zstd_bin);
     }
 
 
@@ -104,8 +143,39 @@ namespace snapper
     }
 
 
+    std::shared_ptr<SshSession>
+    BackupConfig::start_ssh_session() const
+    {
+	if (target_mode != TargetMode::SSH_PUSH || !ssh_master_control)
+	    return nullptr;
+
+	std::shared_ptr<SshSession> tmp = ssh_session.lock();
+
+	if (!tmp)
+	{
+	    tmp = std::make_shared<SshSession>(ssh_connection_options(), ssh_host);
+	    ssh_session = tmp;
+	}
+
+	return tmp;
+    }
+
+
     vector<string>
-    BackupConfig::ssh_options() const
+    BackupConfig::get_ssh_control_options() const
+    {
+	if (std::shared_ptr<SshSession> tmp = ssh_session.lock())
+	    return tmp->control_options();
+
+	if (ssh_master_control)
+	    return { "-o", "ControlMaster=auto", "-o", "ControlPath=\"~/.ssh/snbk-%C\"", "-o", "ControlPersist=30s" };
+
+	return {};
+    }
+
+
+    vector<string>
+    BackupConfig::ssh_connection_options() const
     {
 	vector<string> options;
 
@@ -118,9 +188,17 @@ namespace snapper
 	if (!ssh_identity.empty())
 	    options.insert(options.end(), { "-i", ssh_identity });
 
-	if (ssh_master_control)
-	    options.insert(options.end(), { "-o", "ControlMaster=auto", "-o", "ControlPath=\"~/.ssh/snbk-%C\"",
-		"-o", "ControlPersist=30s" });
+	return options;
+    }
+
+
+    vector<string>
+    BackupConfig::ssh_options() const
+    {
+	vector<string> options = ssh_connection_options();
+
+	const vector<string> control_options = get_ssh_control_options();
+	options.insert(options.end(), control_options.begin(), control_options.end());
 
 	// The target host must be the final argument before the command string execution block
 	options.push_back(ssh_host);
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include <snapper/Enum.h>
 
@@ -49,6 +50,11 @@ namespace snapper
 	    LOCAL, SSH_PUSH
 	};
 
+	enum class Compression
+	{
+	    NONE, ZSTD
+	};
+
 	BackupConfig(const string& name);
 
 	const string name;
@@ -70,21 +76,70 @@ namespace snapper
 	Shell get_source_shell() const;
 	Shell get_target_shell() const;
 
+	/**
+	 * Start an ssh session for the target. Until the returned object
+	 * is destroyed all ssh commands of the target shell use the
+	 * session. If a session is already running it is reused. Returns
+	 * nullptr unless the target-mode is ssh-push and ssh master
+	 * control is enabled.
+	 */
+	std::shared_ptr<SshSession> start_ssh_session() const;
+
+	/**
+	 * The ssh options to use the ssh session or to share connections
+	 * otherwise. Also used for scp.
+	 */
+	vector<string> get_ssh_control_options() const;
+
 	bool send_compressed_data = true;
 	vector<string> send_options;
 	vector<string> receive_options;
 
+	/**
+	 * Limit for the throughput of transfers and restores in bytes
+	 * per second. 0 means no limit.
+	 */
+	unsigned long long transfer_rate_limit = 0;
+
+	/**
+	 * Save the stream of a transfer on the target before receiving it
+	 * so that an interrupted transfer can be continued.
+	 */
+	bool resumable_transfers = false;
+
+	/**
+	 * Compression of the btrfs send stream for target-mode ssh-push.
+	 * A compression level of 0 lets zstd adapt the level to the
+	 * throughput of the link. 0 compression threads means one
+	 * thread per CPU.
+	 */
+	Compression compression = Compression::NONE;
+	unsigned int compression_level = 3;
+	unsigned int compression_threads = 0;
+
+	/**
+	 * Cache the probed snapshots on the target, see StateCache. All
+	 * snapshots are probed again once the cache is older than the
+	 * max age in seconds.
+	 */
+	bool state_cache = false;
+	unsigned int state_cache_max_age = 86400;
+
 	string target_btrfs_bin = BTRFS_BIN;
 	string target_ls_bin = LS_BIN;
 	string target_mkdir_bin = MKDIR_BIN;
 	string target_rm_bin = RM_BIN;
 	string target_rmdir_bin = RMDIR_BIN;
 	string target_sha256sum_bin = SHA256SUM_BIN;
+	string target_zstd_bin = ZSTD_BIN;
 
     private:
 
+	vector<string> ssh_connection_options() const;
 	vector<string> ssh_options() const;
 
+	mutable std::weak_ptr<SshSession> ssh_session;
+
     };
 
 
@@ -93,6 +148,8 @@ namespace snapper
 
     template <> struct EnumInfo<BackupConfig::TargetMode> { static const vector<string> names; };
 
+    template <> struct EnumInfo<BackupConfig::Compression> { static const vector<string> names; };
+
 
     vector<string>
     read_backup_config_names();
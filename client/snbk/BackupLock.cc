@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <iostream>
+
+#include "snapper/SnapperDefines.h"
+#include "snapper/AppUtil.h"
+#include "snapper/Exception.h"
+#include "snapper/LoggerImpl.h"
+
+#include "../utils/text.h"
+
+#include "BackupConfig.h"
+#include "BackupLock.h"
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+    BackupLock::BackupLock(const BackupConfig& backup_config, Mode mode, bool verbose)
+    {
+	const int operation = mode == Mode::SHARED ? LOCK_SH : LOCK_EX;
+
+	if (mkdir(SNBK_LOCK_DIR, 0700) != 0 && errno != EEXIST)
+	    SN_THROW(IOErrorException(sformat("mkdir '%s' failed, errno:%d (%s)", SNBK_LOCK_DIR,
+					      errno, stringerror(errno).c_str())));
+
+	const string filename = SNBK_LOCK_DIR "/" + backup_config.name + ".lock";
+
+	fd = open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0)
+	    SN_THROW(IOErrorException(sformat("open '%s' failed, errno:%d (%s)", filename.c_str(),
+					      errno, stringerror(errno).c_str())));
+
+	int r = flock(fd, operation | LOCK_NB);
+
+	if (r != 0 && errno == EWOULDBLOCK)
+	{
+	    y2mil("waiting for lock of backup config " << backup_config.name);
+
+	    if (verbose)
+		cout << sformat(_("Waiting for other snbk using backup config '%s'."),
+				backup_config.name.c_str()) << endl;
+
+	    do
+		r = flock(fd, operation);
+	    while (r != 0 && errno == EINTR);
+	}
+
+	if (r != 0)
+	{
+	    int errnum = errno;
+
+	    close(fd);
+
+	    SN_THROW(IOErrorException(sformat("flock '%s' failed, errno:%d (%s)", filename.c_str(),
+					      errnum, stringerror(errnum).c_str())));
+	}
+    }
+
+
+    BackupLock::~BackupLock()
+    {
+	// Closing the file releases the lock. The file is not removed since
+	// another snbk might already wait for the lock of it.
+
+	close(fd);
+    }
+
+}
@@ -1,6 +1,5 @@
 /*
- * Copyright (c) [2004-2015] Novell, Inc.
- * Copyright (c) [2016-2025] SUSE LLC
+ * Copyright (c) 2026 SUSE LLC
  *
  * All Rights Reserved.
  *
@@ -21,42 +20,46 @@
  */
 
 
-#ifndef SNAPPER_CMD_LS_H
-#define SNAPPER_CMD_LS_H
 
+#ifndef SNAPPER_BACKUP_LOCK_H
+#define SNAPPER_BACKUP_LOCK_H
 
-#include "Shell.h"
+
+#include <string>
 
 
 namespace snapper
 {
+
     using std::string;
-    using std::vector;
+
+
+    class BackupConfig;
 
 
     /**
-     * A sequence of file names found in a pathname.
+     * Lock for a backup config held by a running snbk. Prevents that several
+     * snbk, e.g. watch and the timer, modify the target of the same backup
+     * config at the same time. Commands that only probe take a shared lock,
+     * commands that transfer or delete snapshots an exclusive lock. The
+     * constructor waits until the lock is available. The lock is released by
+     * the destructor or when the process ends.
      */
-    class CmdLs
+    class BackupLock
     {
     public:
 
-	CmdLs(const string& ls_bin, const Shell& shell, const string& path);
+	enum class Mode { SHARED, EXCLUSIVE };
 
-	typedef vector<string>::const_iterator const_iterator;
+	BackupLock(const BackupConfig& backup_config, Mode mode, bool verbose);
+	~BackupLock();
 
-	const_iterator begin() const { return entries.begin(); }
-	const_iterator end() const { return entries.end(); }
-
-	friend std::ostream& operator<<(std::ostream& s, const CmdLs& cmd_ls);
+	BackupLock(const BackupLock&) = delete;
+	BackupLock& operator=(const BackupLock&) = delete;
 
     private:
 
-	void parse(const vector<string>& lines);
-
-	const string path;
-
-	vector<string> entries;
+	int fd = -1;
 
     };
 
@@ -58,6 +58,12 @@ namespace snapper
     }
 
 
+    CmdBtrfsSubvolumeShow::CmdBtrfsSubvolumeShow(const vector<string>& lines)
+    {
+	parse(lines);
+    }
+
+
     void
     CmdBtrfsSubvolumeShow::parse(const vector<string>& lines)
     {
@@ -45,6 +45,12 @@ namespace snapper
 
 	CmdBtrfsSubvolumeShow(const string& btrfs_bin, const Shell& shell, const string& mount_point);
 
+	/**
+	 * Parse the output of "btrfs subvolume show" that was run as part
+	 * of another command.
+	 */
+	explicit CmdBtrfsSubvolumeShow(const vector<string>& lines);
+
 	const string& get_uuid() const { return uuid; }
 	const string& get_parent_uuid() const { return parent_uuid; }
 	const string& get_received_uuid() const { return received_uuid; }
@@ -58,6 +58,15 @@ namespace snapper
     }
 
 
+    CmdChecksum::CmdChecksum(const string& path, const vector<string>& lines)
+	: path(path)
+    {
+	parse(lines);
+
+	y2mil(*this);
+    }
+
+
     void
     CmdChecksum::parse(const vector<string>& lines)
     {
@@ -41,6 +41,12 @@ namespace snapper
 
 	CmdChecksum(const Shell& shell, const string& checksum_bin, const string& path);
 
+	/**
+	 * Parse the output of the checksum program that was run as part of
+	 * another command.
+	 */
+	CmdChecksum(const string& path, const vector<string>& lines);
+
 	const string& get_checksum() const { return checksum; }
 
 	friend std::ostream& operator<<(std::ostream& s, const CmdChecksum& cmd_checksum);
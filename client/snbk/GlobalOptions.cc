@@ -56,6 +56,7 @@ namespace snapper
 	    { _("--no-headers"), _("No headers for CSV output format.") },
 	    { _("--backup-config, -b <name>"), _("Set name of backup-config to use.") },
 	    { _("--no-dbus"), _("Operate without DBus.") },
+	    { _("--full-probe"), _("Probe all snapshots on the target ignoring the state cache.") },
 	    { _("--version"), _("Print version and exit.") }
 	});
     }
@@ -79,6 +80,7 @@ namespace snapper
 	    Option("no-headers",		no_argument),
 	    Option("backup-config",		required_argument,	'b'),
 	    Option("no-dbus",			no_argument),
+	    Option("full-probe",		no_argument),
 	    Option("version",			no_argument),
 	    Option("help",			no_argument,		'h')
 	};
@@ -95,6 +97,7 @@ namespace snapper
 	_utc = opts.has_option("utc");
 	_iso = opts.has_option("iso");
 	_no_dbus = opts.has_option("no-dbus");
+	_full_probe = opts.has_option("full-probe");
 	_version = opts.has_option("version");
 	_help = opts.has_option("help");
 	_table_style = table_style_value(opts);
@@ -55,6 +55,7 @@ namespace snapper
 	bool utc() const { return _utc; }
 	bool iso() const { return _iso; }
 	bool no_dbus() const { return _no_dbus; }
+	bool full_probe() const { return _full_probe; }
 	bool version() const { return _version; }
 	bool help() const { return _help; }
 	Style table_style() const { return _table_style; }
@@ -81,6 +82,7 @@ namespace snapper
 	bool _utc;
 	bool _iso;
 	bool _no_dbus;
+	bool _full_probe;
 	bool _version;
 	bool _help;
 	Style _table_style;
@@ -20,8 +20,16 @@
  */
 
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+
 #include "snapper/SnapperDefines.h"
 #include "snapper/Exception.h"
+#include "snapper/AppUtil.h"
+#include "snapper/LoggerImpl.h"
+
+#include "../utils/text.h"
 
 #include "Shell.h"
 
@@ -56,44 +64,50 @@ namespace snapper
 	    return quote(args.get_values());
 	}
 
+    }
 
-	string
-	wrap_shell_args(const Shell& shell, const SystemCmd::Args& args)
-	{
-	    const string tmp = quote(args);
 
-	    switch (shell.mode)
+    SystemCmd::Args
+    shellify(const Shell& shell, const SystemCmd::Args& args1)
+    {
+	switch (shell.mode)
+	{
+	    case Shell::Mode::DIRECT:
 	    {
-		case Shell::Mode::DIRECT:
-		    return tmp;
-
-		case Shell::Mode::SSH:
-		    return SSH_BIN " " + quote(shell.ssh_options) + " " +
-			SystemCmd::quote(tmp);
+		return args1;
 	    }
 
-	    SN_THROW(Exception("invalid shell mode"));
-	    __builtin_unreachable();
+	    case Shell::Mode::SSH:
+	    {
+		SystemCmd::Args args2 = { SSH_BIN };
+		args2 << shell.ssh_options << quote(args1);
+		return args2;
+	    }
 	}
 
+	SN_THROW(Exception("invalid shell mode"));
+	__builtin_unreachable();
     }
 
 
     SystemCmd::Args
-    shellify(const Shell& shell, const SystemCmd::Args& args1)
+    shellify_pipe(const Shell& shell, const SystemCmd::Args& args1,
+		  const SystemCmd::Args& args2)
     {
+	const string tmp = quote(args1) + " | " + quote(args2);
+
 	switch (shell.mode)
 	{
 	    case Shell::Mode::DIRECT:
 	    {
-		return args1;
+		return { SH_BIN, "-c", tmp };
 	    }
 
 	    case Shell::Mode::SSH:
 	    {
-		SystemCmd::Args args2 = { SSH_BIN };
-		args2 << shell.ssh_options << quote(args1);
-		return args2;
+		SystemCmd::Args args3 = { SSH_BIN };
+		args3 << shell.ssh_options << tmp;
+		return args3;
 	    }
 	}
 
@@ -102,12 +116,99 @@ namespace snapper
     }
 
 
+    SshSession::SshSession(const vector<string>& ssh_options, const string& host)
+	: ssh_options(ssh_options), host(host)
+    {
+	// The control socket is placed in a private directory.
+
+	char tmp[] = "/tmp/snbk-XXXXXX";
+	if (!mkdtemp(tmp))
+	    SN_THROW(IOErrorException(sformat("mkdtemp failed errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+
+	tmp_dir = tmp;
+	control_path = tmp_dir + "/control";
+	stderr_path = tmp_dir + "/stderr";
+
+	// With -f ssh goes to background after authentication. The master
+	// keeps the output of the command open so it cannot be read via a
+	// pipe until the master exits. Instead stderr is redirected to a file
+	// in the private directory and logged later. Whether the master is
+	// running is checked afterwards.
+
+	// ControlPersist stops the master after some idle time even if snbk
+	// is killed before it can stop the master.
+
+	SystemCmd::Args cmd1_args = { SH_BIN, "-c", "f=\"$1\"; shift; exec \"$@\" < /dev/null > /dev/null 2> \"$f\"",
+				      "snbk-ssh", stderr_path };
+	cmd1_args << args({ "-f", "-N", "-o", "ControlMaster=yes", "-o", "ControlPersist=60" }).get_values();
+	SystemCmd cmd1(cmd1_args);
+
+	SystemCmd cmd2(args({ "-O", "check" }));
+	if (cmd2.retcode() != 0)
+	{
+	    y2err("command '" << cmd2.cmd() << "' failed: " << cmd2.retcode());
+	    for (const string& tmp : cmd2.get_stderr())
+		y2err(tmp);
+
+	    log_master_stderr();
+
+	    rmdir(tmp_dir.c_str());
+
+	    SN_THROW(Exception(_("Starting ssh session failed.")));
+	}
+
+	y2mil("ssh session started, control-path:" << control_path);
+    }
+
+
+    SshSession::~SshSession()
+    {
+	SystemCmd cmd(args({ "-O", "exit" }));
+	if (cmd.retcode() != 0)
+	{
+	    y2err("command '" << cmd.cmd() << "' failed: " << cmd.retcode());
+	    for (const string& tmp : cmd.get_stderr())
+		y2err(tmp);
+	}
+
+	// Normally the master removes the socket itself.
+
+	unlink(control_path.c_str());
+
+	log_master_stderr();
+
+	if (rmdir(tmp_dir.c_str()) != 0)
+	    y2err("rmdir failed, errno:" << errno << " (" << stringerror(errno) << ")");
+    }
+
+
+    void
+    SshSession::log_master_stderr() const
+    {
+	std::ifstream file(stderr_path);
+
+	string line;
+	while (getline(file, line))
+	    y2err("ssh master: " << line);
+
+	unlink(stderr_path.c_str());
+    }
+
+
+    vector<string>
+    SshSession::control_options() const
+    {
+	return { "-o", "ControlMaster=no", "-o", "ControlPath=" + control_path };
+    }
+
+
     SystemCmd::Args
-    shellify_pipe(const Shell& shell1, const SystemCmd::Args& args1,
-		  const Shell& shell2, const SystemCmd::Args& args2)
+    SshSession::args(const vector<string>& extra_options) const
     {
-	return { SH_BIN, "-c", wrap_shell_args(shell1, args1) + " | " +
-	    wrap_shell_args(shell2, args2) };
+	SystemCmd::Args ret = { SSH_BIN };
+	ret << ssh_options << extra_options << "-o" << "ControlPath=" + control_path << host;
+	return ret;
     }
 
 }
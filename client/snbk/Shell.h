@@ -53,9 +53,57 @@ namespace snapper
     shellify(const Shell& shell, const SystemCmd::Args& args);
 
 
+    /**
+     * Like shellify() but for a pipe of two commands, both run by the
+     * shell.
+     */
     SystemCmd::Args
-    shellify_pipe(const Shell& shell1, const SystemCmd::Args& args1,
-		  const Shell& shell2, const SystemCmd::Args& args2);
+    shellify_pipe(const Shell& shell, const SystemCmd::Args& args1,
+		  const SystemCmd::Args& args2);
+
+
+    /**
+     * An ssh master connection owned by snbk. ssh commands using the
+     * control options of the session are multiplexed over the master
+     * connection, so only one handshake is needed for all of them. The
+     * master is started by the constructor and stopped by the destructor.
+     */
+    class SshSession
+    {
+    public:
+
+	/**
+	 * The ssh options must not include the host, the host is passed
+	 * separately.
+	 */
+	SshSession(const vector<string>& ssh_options, const string& host);
+	~SshSession();
+
+	SshSession(const SshSession&) = delete;
+	SshSession& operator=(const SshSession&) = delete;
+
+	/**
+	 * The ssh options to use the master connection.
+	 */
+	vector<string> control_options() const;
+
+    private:
+
+	SystemCmd::Args args(const vector<string>& extra_options) const;
+
+	/**
+	 * Log the stderr output of the master and remove the file.
+	 */
+	void log_master_stderr() const;
+
+	const vector<string> ssh_options;
+	const string host;
+
+	string tmp_dir;
+	string control_path;
+	string stderr_path;
+
+    };
 
 }
 
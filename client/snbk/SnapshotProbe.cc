@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include "config.h"
+
+#include <sys/stat.h>
+#include <time.h>
+#include <regex>
+
+#include "snapper/SnapperDefines.h"
+#include "snapper/SystemCmd.h"
+#include "snapper/FileUtils.h"
+#include "snapper/BtrfsUtils.h"
+#include "snapper/Exception.h"
+#include "snapper/LoggerImpl.h"
+#include "snapper/InfoXml.h"
+
+#include "CmdBtrfs.h"
+#include "CmdChecksum.h"
+#include "SnapshotProbe.h"
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+    namespace
+    {
+
+#ifdef HAVE_LIBBTRFS
+
+	// Same format as used by 'btrfs subvolume show'.
+	string
+	format_creation_time(time_t t)
+	{
+	    struct tm tm;
+	    localtime_r(&t, &tm);
+
+	    char buffer[64];
+	    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S %z", &tm);
+	    return buffer;
+	}
+
+#endif
+
+
+	void
+	set_subvolume(ProbedSnapshot& probed_snapshot, const CmdBtrfsSubvolumeShow& extra)
+	{
+	    probed_snapshot.has_subvolume = true;
+	    probed_snapshot.uuid = extra.get_uuid();
+	    probed_snapshot.parent_uuid = extra.get_parent_uuid();
+	    probed_snapshot.received_uuid = extra.get_received_uuid();
+	    probed_snapshot.creation_time = extra.get_creation_time();
+	    probed_snapshot.read_only = extra.is_read_only();
+	}
+
+    }
+
+
+    vector<ProbedSnapshot>
+    probe_local(const string& dir, const vector<string>& names)
+    {
+	SDir sdir(dir);
+
+#ifdef HAVE_LIBBTRFS
+	const map<BtrfsUtils::subvolid_t, BtrfsUtils::SubvolumeInfo> subvolume_infos =
+	    BtrfsUtils::get_subvolume_infos(sdir.fd());
+#endif
+
+	vector<ProbedSnapshot> probed_snapshots;
+
+	for (const string& name : names)
+	{
+	    ProbedSnapshot probed_snapshot(name);
+
+	    try
+	    {
+		SDir snapshot_dir(sdir, name);
+
+		try
+		{
+#ifdef HAVE_LIBBTRFS
+		    SDir subvolume_dir(snapshot_dir, SNAPSHOT_NAME);
+
+		    struct stat buf;
+		    if (subvolume_dir.stat(&buf) != 0 || !BtrfsUtils::is_subvolume(buf))
+			SN_THROW(Exception("not a subvolume path:" + subvolume_dir.fullname()));
+
+		    BtrfsUtils::subvolid_t id = BtrfsUtils::get_id(subvolume_dir.fd());
+
+		    map<BtrfsUtils::subvolid_t, BtrfsUtils::SubvolumeInfo>::const_iterator it =
+			subvolume_infos.find(id);
+		    if (it == subvolume_infos.end())
+			SN_THROW(Exception("subvolume not found path:" + subvolume_dir.fullname()));
+
+		    const BtrfsUtils::SubvolumeInfo& subvolume_info = it->second;
+
+		    probed_snapshot.has_subvolume = true;
+		    probed_snapshot.uuid = subvolume_info.uuid;
+		    probed_snapshot.parent_uuid = subvolume_info.parent_uuid;
+		    probed_snapshot.received_uuid = subvolume_info.received_uuid;
+		    if (subvolume_info.otime != 0)
+			probed_snapshot.creation_time = format_creation_time(subvolume_info.otime);
+		    probed_snapshot.read_only = subvolume_info.read_only;
+#else
+		    set_subvolume(probed_snapshot, CmdBtrfsSubvolumeShow(BTRFS_BIN, Shell(), dir + "/" +
+									 name + "/" SNAPSHOT_NAME));
+#endif
+		}
+		catch (const Exception& e)
+		{
+		    SN_CAUGHT(e);
+		}
+		catch (const runtime_error& e)
+		{
+		    y2err("probing subvolume of " << name << " failed, " << e.what());
+		}
+
+		try
+		{
+		    probed_snapshot.checksum = info_xml_checksum(snapshot_dir);
+		    probed_snapshot.has_checksum = true;
+		}
+		catch (const Exception& e)
+		{
+		    SN_CAUGHT(e);
+		}
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+	    }
+
+	    probed_snapshots.push_back(probed_snapshot);
+	}
+
+	return probed_snapshots;
+    }
+
+
+    vector<string>
+    list_local(const string& dir)
+    {
+	SDir sdir(dir);
+
+	// Like ls hidden entries are not listed.
+
+	return sdir.entries([](unsigned char type, const char* name) {
+	    return name[0] != '.';
+	});
+    }
+
+
+    vector<ProbedSnapshot>
+    probe_remote(const Shell& shell, const string& dir, const string& ls_bin, const string& btrfs_bin,
+		 const string& checksum_bin, const map<string, ProbedSnapshot>& known)
+    {
+	// The script outputs for every entry a marker line followed by
+	// the output of 'btrfs subvolume show' and the checksum program,
+	// each followed by a marker line with the exit status. The known
+	// entries are passed as further arguments and only get a marker
+	// line. Known entries are snapshot numbers and thus never contain
+	// a space.
+
+	static const char* script =
+	    "entries=$(\"$2\" -1 --sort=none -- \"$1\") || exit 1\n"
+	    "dir=$1 ls=$2 btrfs=$3 checksum=$4\n"
+	    "shift 4\n"
+	    "known=\" $* \"\n"
+	    "set -- \"$dir\" \"$ls\" \"$btrfs\" \"$checksum\"\n"
+	    "printf '%s\\n' \"$entries\" | while IFS= read -r n; do\n"
+	    "    [ -n \"$n\" ] || continue\n"
+	    "    case \"$known\" in *\" $n \"*)\n"
+	    "        printf 'snbk-probe known %s\\n' \"$n\"\n"
+	    "        continue ;;\n"
+	    "    esac\n"
+	    "    printf 'snbk-probe entry %s\\n' \"$n\"\n"
+	    "    \"$3\" subvolume show -- \"$1/$n/" SNAPSHOT_NAME "\" 2> /dev/null\n"
+	    "    printf 'snbk-probe show %d\\n' $?\n"
+	    "    \"$4\" -- \"$1/$n/info.xml\" 2> /dev/null\n"
+	    "    printf 'snbk-probe checksum %d\\n' $?\n"
+	    "done\n";
+
+	SystemCmd::Args cmd_args = { SH_BIN, "-c", script, "snbk-probe", dir, ls_bin, btrfs_bin,
+				     checksum_bin };
+
+	for (const map<string, ProbedSnapshot>::value_type& value : known)
+	    cmd_args << value.first;
+	SystemCmd cmd(shellify(shell, cmd_args));
+
+	if (cmd.retcode() != 0)
+	{
+	    y2err("command '" << cmd.cmd() << "' failed: " << cmd.retcode());
+	    for (const string& tmp : cmd.get_stdout())
+		y2err(tmp);
+	    for (const string& tmp : cmd.get_stderr())
+		y2err(tmp);
+
+	    SN_THROW(Exception("probing snapshots failed"));
+	}
+
+	static const regex entry_regex("snbk-probe entry (.*)", regex::extended);
+	static const regex known_regex("snbk-probe known (.*)", regex::extended);
+	static const regex show_regex("snbk-probe show ([0-9]+)", regex::extended);
+	static const regex checksum_regex("snbk-probe checksum ([0-9]+)", regex::extended);
+
+	vector<ProbedSnapshot> probed_snapshots;
+	vector<string> lines;
+
+	smatch match;
+
+	for (const string& line : cmd.get_stdout())
+	{
+	    if (regex_match(line, match, entry_regex))
+	    {
+		probed_snapshots.emplace_back(match[1]);
+		lines.clear();
+	    }
+	    else if (regex_match(line, match, known_regex))
+	    {
+		map<string, ProbedSnapshot>::const_iterator it = known.find(match[1]);
+		if (it == known.end())
+		    SN_THROW(Exception("unexpected output while probing snapshots"));
+
+		probed_snapshots.push_back(it->second);
+		lines.clear();
+	    }
+	    else if (probed_snapshots.empty())
+	    {
+		SN_THROW(Exception("unexpected output while probing snapshots"));
+	    }
+	    else if (regex_match(line, match, show_regex))
+	    {
+		if (match[1] == "0")
+		{
+		    try
+		    {
+			set_subvolume(probed_snapshots.back(), CmdBtrfsSubvolumeShow(lines));
+		    }
+		    catch (const Exception& e)
+		    {
+			SN_CAUGHT(e);
+		    }
+		}
+
+		lines.clear();
+	    }
+	    else if (regex_match(line, match, checksum_regex))
+	    {
+		if (match[1] == "0")
+		{
+		    ProbedSnapshot& probed_snapshot = probed_snapshots.back();
+
+		    try
+		    {
+			CmdChecksum cmd_checksum(dir + "/" + probed_snapshot.name + "/info.xml", lines);
+			probed_snapshot.checksum = cmd_checksum.get_checksum();
+			probed_snapshot.has_checksum = true;
+		    }
+		    catch (const Exception& e)
+		    {
+			SN_CAUGHT(e);
+		    }
+		}
+
+		lines.clear();
+	    }
+	    else
+	    {
+		lines.push_back(line);
+	    }
+	}
+
+	return probed_snapshots;
+    }
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#ifndef SNAPPER_SNAPSHOT_PROBE_H
+#define SNAPPER_SNAPSHOT_PROBE_H
+
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Shell.h"
+
+
+namespace snapper
+{
+
+    using std::string;
+    using std::vector;
+    using std::map;
+
+
+    /**
+     * Information about a snapshot directory, i.e. the subvolume and the
+     * checksum of info.xml. The same information was previously queried
+     * with CmdBtrfsSubvolumeShow and CmdChecksum for every snapshot.
+     */
+    struct ProbedSnapshot
+    {
+	ProbedSnapshot(const string& name) : name(name) {}
+
+	string name;
+
+	bool has_subvolume = false;
+
+	string uuid;
+	string parent_uuid;
+	string received_uuid;
+	string creation_time;
+	bool read_only = false;
+
+	bool has_checksum = false;
+
+	string checksum;
+    };
+
+
+    /**
+     * Probe the snapshots with the given names in the local directory
+     * dir. The subvolume information is queried with a single tree
+     * search. The checksums are taken from the checksum files written by
+     * snapper or computed in-process.
+     */
+    vector<ProbedSnapshot>
+    probe_local(const string& dir, const vector<string>& names);
+
+
+    /**
+     * List the local directory dir like ls does.
+     */
+    vector<string>
+    list_local(const string& dir);
+
+
+    /**
+     * List the directory dir and probe all entries with a single command
+     * run in shell, e.g. on a remote host. The command returns the
+     * information of all entries in one stream. Entries found in known
+     * are not probed, instead the known information is returned.
+     */
+    vector<ProbedSnapshot>
+    probe_remote(const Shell& shell, const string& dir, const string& ls_bin, const string& btrfs_bin,
+		 const string& checksum_bin, const map<string, ProbedSnapshot>& known = {});
+
+}
+
+#endif
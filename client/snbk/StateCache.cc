@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#include "snapper/SnapperDefines.h"
+#include "snapper/AppUtil.h"
+#include "snapper/Exception.h"
+#include "snapper/LoggerImpl.h"
+
+#include "BackupConfig.h"
+#include "JsonFile.h"
+#include "StateCache.h"
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+    namespace
+    {
+
+	string
+	target_identity(const BackupConfig& backup_config)
+	{
+	    string ret = toString(backup_config.target_mode) + " ";
+
+	    if (backup_config.target_mode == BackupConfig::TargetMode::SSH_PUSH)
+	    {
+		if (!backup_config.ssh_user.empty())
+		    ret += backup_config.ssh_user + "@";
+
+		ret += backup_config.ssh_host;
+
+		if (backup_config.ssh_port != 0)
+		    ret += ":" + to_string(backup_config.ssh_port);
+
+		ret += " ";
+	    }
+
+	    return ret + backup_config.target_path;
+	}
+
+
+	void
+	mkdir_if_missing(const char* path)
+	{
+	    if (mkdir(path, 0700) != 0 && errno != EEXIST)
+		SN_THROW(Exception(sformat("mkdir '%s' failed, errno:%d (%s)", path, errno,
+					   stringerror(errno).c_str())));
+	}
+
+
+	void
+	add_string(json_object* parent, const char* name, const string& value)
+	{
+	    json_object_object_add(parent, name, json_object_new_string(value.c_str()));
+	}
+
+    }
+
+
+    StateCache::StateCache(const BackupConfig& backup_config)
+	: enabled(backup_config.state_cache), max_age(backup_config.state_cache_max_age),
+	  filename(SNBK_STATE_CACHE_DIR "/" + backup_config.name + ".json"),
+	  target(target_identity(backup_config))
+    {
+	if (!enabled)
+	    return;
+
+	try
+	{
+	    load();
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2war("ignoring state cache '" << filename << "'");
+
+	    verified = 0;
+	    target_snapshots.clear();
+	}
+
+	if (needs_full_probe())
+	    target_snapshots.clear();
+    }
+
+
+    bool
+    StateCache::needs_full_probe() const
+    {
+	if (!enabled)
+	    return true;
+
+	time_t now = time(nullptr);
+
+	return verified == 0 || now < verified || now - verified >= (time_t)(max_age);
+    }
+
+
+    const map<string, ProbedSnapshot>&
+    StateCache::get_target_snapshots() const
+    {
+	return target_snapshots;
+    }
+
+
+    void
+    StateCache::update(const vector<ProbedSnapshot>& probed_snapshots, bool full_probe)
+    {
+	if (!enabled)
+	    return;
+
+	target_snapshots.clear();
+
+	for (const ProbedSnapshot& probed_snapshot : probed_snapshots)
+	{
+	    if (probed_snapshot.has_subvolume && probed_snapshot.read_only && probed_snapshot.has_checksum)
+		target_snapshots.emplace(probed_snapshot.name, probed_snapshot);
+	}
+
+	if (full_probe)
+	    verified = time(nullptr);
+
+	save();
+    }
+
+
+    void
+    StateCache::erase(unsigned int num)
+    {
+	if (!enabled)
+	    return;
+
+	if (target_snapshots.erase(to_string(num)) == 0)
+	    return;
+
+	save();
+    }
+
+
+    void
+    StateCache::erase(const vector<unsigned int>& nums)
+    {
+	if (!enabled)
+	    return;
+
+	bool changed = false;
+
+	for (unsigned int num : nums)
+	{
+	    if (target_snapshots.erase(to_string(num)) != 0)
+		changed = true;
+	}
+
+	if (changed)
+	    save();
+    }
+
+
+    void
+    StateCache::load()
+    {
+	if (access(filename.c_str(), F_OK) != 0)
+	    return;
+
+	JsonFile json_file(filename);
+
+	string tmp;
+	if (!get_child_value(json_file.get_root(), "target", tmp) || tmp != target)
+	{
+	    y2mil("target of state cache '" << filename << "' changed");
+	    return;
+	}
+
+	unsigned int tmp_verified = 0;
+	if (!get_child_value(json_file.get_root(), "verified", tmp_verified))
+	    SN_THROW(Exception("verified entry not found"));
+
+	vector<json_object*> children;
+	if (!get_child_nodes(json_file.get_root(), "snapshots", children))
+	    SN_THROW(Exception("snapshots entry not found"));
+
+	for (json_object* child : children)
+	{
+	    string name;
+	    if (!get_child_value(child, "name", name))
+		SN_THROW(Exception("name entry not found"));
+
+	    ProbedSnapshot probed_snapshot(name);
+	    probed_snapshot.has_subvolume = true;
+	    probed_snapshot.read_only = true;
+	    probed_snapshot.has_checksum = true;
+
+	    if (!get_child_value(child, "uuid", probed_snapshot.uuid) ||
+		!get_child_value(child, "parent-uuid", probed_snapshot.parent_uuid) ||
+		!get_child_value(child, "received-uuid", probed_snapshot.received_uuid) ||
+		!get_child_value(child, "creation-time", probed_snapshot.creation_time) ||
+		!get_child_value(child, "checksum", probed_snapshot.checksum))
+		SN_THROW(Exception(sformat("incomplete entry for '%s'", name.c_str())));
+
+	    target_snapshots.emplace(name, probed_snapshot);
+	}
+
+	verified = tmp_verified;
+    }
+
+
+    void
+    StateCache::save() const
+    {
+	// Failing to save the cache only makes the next run slower.
+
+	try
+	{
+	    mkdir_if_missing(CACHE_DIR);
+	    mkdir_if_missing(SNBK_STATE_CACHE_DIR);
+
+	    json_object* root = json_object_new_object();
+
+	    add_string(root, "target", target);
+	    json_object_object_add(root, "verified", json_object_new_int64(verified));
+
+	    json_object* snapshots = json_object_new_array();
+
+	    for (const map<string, ProbedSnapshot>::value_type& value : target_snapshots)
+	    {
+		const ProbedSnapshot& probed_snapshot = value.second;
+
+		json_object* snapshot = json_object_new_object();
+		add_string(snapshot, "name", probed_snapshot.name);
+		add_string(snapshot, "uuid", probed_snapshot.uuid);
+		add_string(snapshot, "parent-uuid", probed_snapshot.parent_uuid);
+		add_string(snapshot, "received-uuid", probed_snapshot.received_uuid);
+		add_string(snapshot, "creation-time", probed_snapshot.creation_time);
+		add_string(snapshot, "checksum", probed_snapshot.checksum);
+		json_object_array_add(snapshots, snapshot);
+	    }
+
+	    json_object_object_add(root, "snapshots", snapshots);
+
+	    // Write a temporary file and rename it so that an interrupted run
+	    // never leaves a truncated cache. The name of the temporary file
+	    // is unique since several snbk only listing snapshots can save
+	    // the cache at the same time.
+
+	    const string tmp_filename = filename + ".tmp." + to_string(getpid());
+
+	    ofstream s(tmp_filename);
+	    s << json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY) << '\n';
+	    s.close();
+
+	    json_object_put(root);
+
+	    if (!s.good())
+		SN_THROW(Exception(sformat("writing '%s' failed", tmp_filename.c_str())));
+
+	    if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+		SN_THROW(Exception(sformat("rename '%s' failed, errno:%d (%s)", tmp_filename.c_str(),
+					   errno, stringerror(errno).c_str())));
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2war("saving state cache '" << filename << "' failed");
+	}
+    }
+
+}
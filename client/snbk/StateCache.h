@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#ifndef SNAPPER_STATE_CACHE_H
+#define SNAPPER_STATE_CACHE_H
+
+
+#include <time.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "SnapshotProbe.h"
+
+
+namespace snapper
+{
+
+    using std::string;
+    using std::vector;
+    using std::map;
+
+
+    class BackupConfig;
+
+
+    /**
+     * Cache for the probed snapshots on the target of a backup config.
+     * Only snapshots that are not in the cache have to be probed,
+     * e.g. with 'btrfs subvolume show' and sha256sum on a remote host.
+     *
+     * Only complete information of read-only snapshots is cached. The
+     * states are still derived from the cached information and the
+     * probed source snapshots on every run, so changed metadata on the
+     * source is detected without the cache. Snapshots modified on the
+     * target by snbk must be erased from the cache before the
+     * modification. Other modifications of the target are only detected
+     * by a full probe which is done once the cache is older than the
+     * state-cache-max-age of the backup config.
+     */
+    class StateCache
+    {
+    public:
+
+	/**
+	 * Loads the cache if enabled for the backup config. A missing,
+	 * unreadable or outdated cache file is ignored.
+	 */
+	StateCache(const BackupConfig& backup_config);
+
+	/**
+	 * Whether all snapshots on the target must be probed.
+	 */
+	bool needs_full_probe() const;
+
+	/**
+	 * The cached snapshots by name. Empty if a full probe is needed.
+	 */
+	const map<string, ProbedSnapshot>& get_target_snapshots() const;
+
+	/**
+	 * Replace the cached snapshots with the snapshots on the target
+	 * and save the cache.
+	 */
+	void update(const vector<ProbedSnapshot>& probed_snapshots, bool full_probe);
+
+	/**
+	 * Remove a snapshot from the cache and save the cache.
+	 */
+	void erase(unsigned int num);
+
+	/**
+	 * Remove several snapshots from the cache and save the cache once.
+	 */
+	void erase(const vector<unsigned int>& nums);
+
+    private:
+
+	void load();
+	void save() const;
+
+	const bool enabled;
+	const unsigned int max_age;
+	const string filename;
+
+	/** Identifies the target so that the cache is dropped if it changes. */
+	const string target;
+
+	/** Time of the last full probe. */
+	time_t verified = 0;
+
+	map<string, ProbedSnapshot> target_snapshots;
+
+    };
+
+}
+
+#endif
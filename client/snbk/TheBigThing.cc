@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <regex>
+#include <boost/thread.hpp>
 
 #include "snapper/SystemCmd.h"
 #include "snapper/SnapperDefines.h"
@@ -31,10 +32,11 @@
 
 #include "../proxy/proxy.h"
 #include "../utils/text.h"
+#include "../utils/HumanString.h"
+#include "../utils/StreamCopy.h"
 
 #include "CmdBtrfs.h"
-#include "CmdLs.h"
-#include "CmdChecksum.h"
+#include "SnapshotProbe.h"
 #include "BackupConfig.h"
 #include "TheBigThing.h"
 
@@ -122,6 +124,92 @@ namespace snapper
 	    return backup_config.target_path + "/" + to_string(num);
 	}
 
+	SystemCmd::Args zstd_compress_args(const string& zstd_bin,
+	                                   const BackupConfig& backup_config)
+	{
+	    SystemCmd::Args args = { zstd_bin, "--compress", "--stdout", "--quiet" };
+
+	    if (backup_config.compression_level == 0)
+		args << "--adapt";
+	    else
+		args << "-" + to_string(backup_config.compression_level);
+
+	    args << "-T" + to_string(backup_config.compression_threads);
+
+	    return args;
+	}
+
+	SystemCmd::Args zstd_decompress_args(const string& zstd_bin)
+	{
+	    return { zstd_bin, "--decompress", "--stdout", "--quiet" };
+	}
+
+	const char* const stream_file_name = "snapshot.stream";
+
+	string stream_file(const BackupConfig& backup_config, unsigned int num)
+	{
+	    return target_snapshot_dir(backup_config, num) + "/" + stream_file_name;
+	}
+
+	/**
+	 * Query the size and the SHA-256 of the stream file on the target. Returns
+	 * false if the stream file does not exist.
+	 */
+	bool query_stream_file(const BackupConfig& backup_config, const string& stream_file,
+	                       unsigned long long& size, string& digest)
+	{
+	    static const char* script =
+		"if [ -f \"$1\" ]; then wc -c < \"$1\" && \"$2\" < \"$1\"; fi";
+
+	    SystemCmd::Args cmd_args = { SH_BIN, "-c", script, "snbk-stream", stream_file,
+	                                 backup_config.target_sha256sum_bin };
+	    SystemCmd cmd(shellify(backup_config.get_target_shell(), cmd_args));
+	    if (cmd.retcode() != 0)
+	    {
+		y2err("command '" << cmd.cmd() << "' failed: " << cmd.retcode());
+		for (const string& tmp : cmd.get_stderr())
+		    y2err(tmp);
+
+		SN_THROW(Exception(_("Querying stream file failed.")));
+	    }
+
+	    const vector<string>& lines = cmd.get_stdout();
+	    if (lines.empty())
+		return false;
+
+	    static const regex size_regex("[ ]*([0-9]+)", regex::extended);
+	    static const regex digest_regex("([0-9a-f]{64}) .*", regex::extended);
+
+	    smatch size_match;
+	    smatch digest_match;
+
+	    if (lines.size() != 2 || !regex_match(lines[0], size_match, size_regex) ||
+		!regex_match(lines[1], digest_match, digest_regex))
+		SN_THROW(Exception(_("Invalid output when querying stream file.")));
+
+	    size = stoull(size_match[1]);
+	    digest = digest_match[1];
+
+	    return true;
+	}
+
+	void remove_stream_file(const BackupConfig& backup_config, const string& stream_file)
+	{
+	    SystemCmd::Args cmd_args = { backup_config.target_rm_bin, "--force", "--",
+	                                 stream_file };
+	    SystemCmd cmd(shellify(backup_config.get_target_shell(), cmd_args));
+	    if (cmd.retcode() != 0)
+	    {
+		y2err("command '" << cmd.cmd() << "' failed: " << cmd.retcode());
+		for (const string& tmp : cmd.get_stdout())
+		    y2err(tmp);
+		for (const string& tmp : cmd.get_stderr())
+		    y2err(tmp);
+
+		SN_THROW(Exception(_("'rm stream' failed.")));
+	    }
+	}
+
     }
 
 
@@ -137,7 +225,7 @@ namespace snapper
 
     void
     TheBigThing::copy(const BackupConfig& backup_config, TheBigThings& the_big_things,
-                           const pair<CopySpec, CopySpec>& copy_specs)
+                           const pair<CopySpec, CopySpec>& copy_specs, bool quiet)
     {
 	// Unpack copy specification
 	const CopySpec& src_spec = copy_specs.first;
@@ -181,21 +269,146 @@ namespace snapper
 	cmd3b_args << backup_config.receive_options;
 	cmd3b_args << "--" << dst_spec.snapshot_dir;
 
+	// For a resumable transfer the stream is first appended to the stream file
+	// and received from the file afterwards. A stream file left by an interrupted
+	// transfer is continued.
+
+	unsigned long long offset = 0;
+	string digest;
+
+	if (!dst_spec.stream_file.empty())
+	{
+	    cmd3b_args = { SH_BIN, "-c", "exec cat >> \"$1\"", "snbk-stream", dst_spec.stream_file };
+
+	    if (query_stream_file(backup_config, dst_spec.stream_file, offset, digest) &&
+		offset != 0 && !quiet)
+	    {
+		boost::lock_guard<boost::mutex> lock(the_big_things.mutex);
+
+		cout << sformat(_("Resuming transfer of snapshot %d after %s."), num,
+				byte_to_humanstring(offset, false, 2).c_str()) << '\n';
+	    }
+	}
+
 	y2deb("source: " << cmd3a_args.get_values());
 	y2deb("destination: " << cmd3b_args.get_values());
 
-	SystemCmd cmd3(
-	    shellify_pipe(src_spec.shell, cmd3a_args, dst_spec.shell, cmd3b_args));
-	if (cmd3.retcode() != 0)
+	SystemCmd::Args source_args = shellify(src_spec.shell, cmd3a_args);
+	SystemCmd::Args destination_args = shellify(dst_spec.shell, cmd3b_args);
+	std::optional<SystemCmd::Args> filter_args;
+
+	// With compression the stream is compressed on the sending side and
+	// decompressed on the receiving side. The part running locally is the
+	// filter of the stream copy.
+	const bool compress = backup_config.target_mode == BackupConfig::TargetMode::SSH_PUSH &&
+	    backup_config.compression == BackupConfig::Compression::ZSTD;
+	const bool compress_locally = dst_spec.shell.mode == Shell::Mode::SSH;
+
+	if (compress)
+	{
+	    if (compress_locally)
+	    {
+		filter_args = zstd_compress_args(src_spec.zstd_bin, backup_config);
+		destination_args = shellify_pipe(dst_spec.shell, zstd_decompress_args(dst_spec.zstd_bin),
+						 cmd3b_args);
+	    }
+	    else
+	    {
+		source_args = shellify_pipe(src_spec.shell, cmd3a_args,
+					    zstd_compress_args(src_spec.zstd_bin, backup_config));
+		filter_args = zstd_decompress_args(dst_spec.zstd_bin);
+	    }
+	}
+
+	// The stream is copied by snbk itself to count the bytes and to limit the
+	// throughput.
+	StreamCopy cmd3(source_args, destination_args);
+	if (filter_args)
+	    cmd3.set_filter(*filter_args);
+	cmd3.set_skip(offset, digest);
+	cmd3.set_rate_limit(backup_config.transfer_rate_limit);
+	cmd3.set_progress_callback([this](const StreamCopy::Progress& progress) {
+	    y2mil("snapshot " << num << ": " << progress.bytes << " bytes in " <<
+		  progress.seconds << " seconds");
+	}, 10);
+	cmd3.run();
+
+	if (!cmd3.get_skip_matched())
+	{
+	    // The send stream does not start with the content of the stream file,
+	    // e.g. since btrfs was updated in between. Start over.
+
+	    y2war("stream file of snapshot " << num << " does not match, starting over");
+
+	    remove_stream_file(backup_config, dst_spec.stream_file);
+
+	    copy(backup_config, the_big_things, copy_specs, quiet);
+	    return;
+	}
+
+	if (cmd3.get_source_retcode() != 0 || cmd3.get_filter_retcode() != 0 ||
+	    cmd3.get_destination_retcode() != 0)
 	{
-	    y2err("command '" << cmd3.cmd() << "' failed: " << cmd3.retcode());
-	    for (const string& tmp : cmd3.get_stdout())
+	    y2err("command '" << cmd3.cmd() << "' failed: " << cmd3.get_source_retcode() <<
+		  " " << cmd3.get_filter_retcode() << " " << cmd3.get_destination_retcode());
+	    for (const string& tmp : cmd3.get_source_output())
+		y2err(tmp);
+	    for (const string& tmp : cmd3.get_filter_output())
 		y2err(tmp);
-	    for (const string& tmp : cmd3.get_stderr())
+	    for (const string& tmp : cmd3.get_destination_output())
 		y2err(tmp);
 
 	    SN_THROW(Exception(_("'btrfs send | btrfs receive' failed.")));
 	}
+
+	if (!quiet)
+	{
+	    const StreamCopy::Progress& progress = cmd3.get_progress();
+
+	    boost::lock_guard<boost::mutex> lock(the_big_things.mutex);
+
+	    // With compression the size of the send stream is the number of bytes
+	    // on the uncompressed side.
+	    unsigned long long stream_bytes = progress.bytes;
+	    unsigned long long compressed_bytes = progress.destination_bytes;
+	    if (compress && !compress_locally)
+		swap(stream_bytes, compressed_bytes);
+
+	    cout << sformat(_("Copied %s of snapshot %d in %.1f seconds (%s/s)."),
+			    byte_to_humanstring(stream_bytes, false, 2).c_str(), num,
+			    progress.seconds,
+			    byte_to_humanstring(stream_bytes / max(progress.seconds, 0.001), false,
+						2).c_str()) << '\n';
+
+	    if (compress)
+		cout << sformat(_("Compressed to %s (ratio %.2f)."),
+				byte_to_humanstring(compressed_bytes, false, 2).c_str(),
+				compressed_bytes != 0 ? (double)(stream_bytes) / compressed_bytes :
+				0.0) << '\n';
+	}
+
+	if (!dst_spec.stream_file.empty())
+	{
+	    SystemCmd::Args cmd4_args = { dst_spec.btrfs_bin, "receive" };
+	    cmd4_args << backup_config.receive_options;
+	    cmd4_args << "-f" << dst_spec.stream_file << "--" << dst_spec.snapshot_dir;
+
+	    SystemCmd cmd4(shellify(dst_spec.shell, cmd4_args));
+
+	    // A stream file that cannot be received is useless.
+	    remove_stream_file(backup_config, dst_spec.stream_file);
+
+	    if (cmd4.retcode() != 0)
+	    {
+		y2err("command '" << cmd4.cmd() << "' failed: " << cmd4.retcode());
+		for (const string& tmp : cmd4.get_stdout())
+		    y2err(tmp);
+		for (const string& tmp : cmd4.get_stderr())
+		    y2err(tmp);
+
+		SN_THROW(Exception(_("'btrfs receive' failed.")));
+	    }
+	}
     }
 
 
@@ -237,6 +450,7 @@ namespace snapper
 		    cmd_args << "-P" << to_string(backup_config.ssh_port);
 		if (!backup_config.ssh_identity.empty())
 		    cmd_args << "-i" << backup_config.ssh_identity;
+		cmd_args << backup_config.get_ssh_control_options();
 		cmd_args << "--"
 		         << src_spec.remote_host + src_spec.snapshot_dir + "/info.xml"
 		         << dst_spec.remote_host + dst_spec.snapshot_dir + "/";
@@ -267,6 +481,10 @@ namespace snapper
 	else if (source_state == SourceState::READ_WRITE)
 	    SN_THROW(Exception(_("Cannot transfer a read-write snapshot.")));
 
+	// The send parent depends on the states of the other snapshots which are
+	// changed by a parallel transfer.
+	boost::unique_lock<boost::mutex> lock(the_big_things.mutex);
+
 	auto copy_specs =
 	    make_copy_specs(backup_config, the_big_things, CopyMode::SOURCE_TO_TARGET);
 	switch (target_state)
@@ -280,17 +498,21 @@ namespace snapper
 		// Copy the snapshot from the source to the target
 		if (!quiet)
 		    cout << sformat(_("Transferring snapshot %d."), num) << '\n';
-		copy(backup_config, the_big_things, copy_specs);
+		lock.unlock();
+		copy(backup_config, the_big_things, copy_specs, quiet);
 		break;
 
 	    case TargetState::LEGACY:
 		// Overwrite the snapshot metadata on the target
 		if (!quiet)
 		    cout << sformat(_("Updating metadata of snapshot %d."), num) << '\n';
+		the_big_things.state_cache.erase(num);
+		lock.unlock();
 		copy_metadata(backup_config, the_big_things, copy_specs);
 		break;
 	}
 
+	lock.lock();
 	target_state = TargetState::VALID;
     }
 
@@ -310,72 +532,19 @@ namespace snapper
 
 	// Copy the snapshot from the target to the source
 	copy(backup_config, the_big_things,
-	     make_copy_specs(backup_config, the_big_things, CopyMode::TARGET_TO_SOURCE));
+	     make_copy_specs(backup_config, the_big_things, CopyMode::TARGET_TO_SOURCE), quiet);
 
 	source_state = SourceState::READ_ONLY;
     }
 
 
     void
-    TheBigThing::remove(const BackupConfig& backup_config, bool quiet)
+    TheBigThing::remove(const BackupConfig& backup_config, TheBigThings& the_big_things, bool quiet)
     {
-	if (!quiet)
-	    cout << sformat(_("Deleting snapshot %d."), num) << '\n';
-
 	if (target_state == TargetState::MISSING)
 	    SN_THROW(Exception(_("Snapshot not on target.")));
 
-	const string num_string = to_string(num);
-
-	// Delete snapshot on target.
-
-	SystemCmd::Args cmd1_args = { backup_config.target_btrfs_bin, "subvolume", "delete", "--",
-	    backup_config.target_path + "/" + num_string + "/" SNAPSHOT_NAME };
-	SystemCmd cmd1(shellify(backup_config.get_target_shell(), cmd1_args));
-	if (cmd1.retcode() != 0)
-	{
-	    y2err("command '" << cmd1.cmd() << "' failed: " << cmd1.retcode());
-	    for (const string& tmp : cmd1.get_stdout())
-		y2err(tmp);
-	    for (const string& tmp : cmd1.get_stderr())
-		y2err(tmp);
-
-	    SN_THROW(Exception(_("'btrfs subvolume delete' failed.")));
-	}
-
-	// Remove info.xml on target.
-
-	SystemCmd::Args cmd2_args = { backup_config.target_rm_bin, "--", backup_config.target_path + "/" + num_string +
-	    "/info.xml" };
-	SystemCmd cmd2(shellify(backup_config.get_target_shell(), cmd2_args));
-	if (cmd2.retcode() != 0)
-	{
-	    y2err("command '" << cmd2.cmd() << "' failed: " << cmd2.retcode());
-	    for (const string& tmp : cmd2.get_stdout())
-		y2err(tmp);
-	    for (const string& tmp : cmd2.get_stderr())
-		y2err(tmp);
-
-	    SN_THROW(Exception(_("'rm info.xml' failed.")));
-	}
-
-	// Remove directory on target.
-
-	SystemCmd::Args cmd3_args = { backup_config.target_rmdir_bin, "--", backup_config.target_path + "/" +
-	    num_string };
-	SystemCmd cmd3(shellify(backup_config.get_target_shell(), cmd3_args));
-	if (cmd3.retcode() != 0)
-	{
-	    y2err("command '" << cmd3.cmd() << "' failed: " << cmd3.retcode());
-	    for (const string& tmp : cmd3.get_stdout())
-		y2err(tmp);
-	    for (const string& tmp : cmd3.get_stderr())
-		y2err(tmp);
-
-	    SN_THROW(Exception(_("'rmdir' failed.")));
-	}
-
-	target_state = TargetState::MISSING;
+	the_big_things.remove_snapshots(backup_config, { this }, quiet);
     }
 
 
@@ -387,14 +556,20 @@ namespace snapper
 	spec_source.shell = backup_config.get_source_shell();
 	spec_source.mkdir_bin = MKDIR_BIN;
 	spec_source.btrfs_bin = BTRFS_BIN;
+	spec_source.zstd_bin = ZSTD_BIN;
 	spec_source.snapshot_dir = source_snapshot_dir(the_big_things.snapper, num);
 
 	CopySpec spec_target; // Copy specification for the snapshot on the target.
 	spec_target.shell = backup_config.get_target_shell();
 	spec_target.mkdir_bin = backup_config.target_mkdir_bin;
 	spec_target.btrfs_bin = backup_config.target_btrfs_bin;
+	spec_target.zstd_bin = backup_config.target_zstd_bin;
 	spec_target.snapshot_dir = target_snapshot_dir(backup_config, num);
 
+	// Only transfers to the target are resumable.
+	if (backup_config.resumable_transfers && copy_mode == CopyMode::SOURCE_TO_TARGET)
+	    spec_target.stream_file = stream_file(backup_config, num);
+
 	// Resolve the remote host when using SSH push.
 	if (backup_config.target_mode == BackupConfig::TargetMode::SSH_PUSH)
 	{
@@ -464,10 +639,13 @@ namespace snapper
     }
 
 
-    TheBigThings::TheBigThings(const BackupConfig& backup_config, ProxySnappers* snappers, bool verbose)
-	: source_btrfs_version(BTRFS_BIN, backup_config.get_source_shell()),
+    TheBigThings::TheBigThings(const BackupConfig& backup_config, ProxySnappers* snappers,
+			       BackupLock::Mode lock_mode, bool verbose)
+	: backup_lock(backup_config, lock_mode, verbose), ssh_session(backup_config.start_ssh_session()),
+	  source_btrfs_version(BTRFS_BIN, backup_config.get_source_shell()),
 	  target_btrfs_version(backup_config.target_btrfs_bin, backup_config.get_target_shell()),
-	  snapper(snappers->getSnapper(backup_config.config)), locker(snapper)
+	  snapper(snappers->getSnapper(backup_config.config)), state_cache(backup_config),
+	  locker(snapper)
     {
 	probe_source(backup_config, verbose);
 	probe_target(backup_config, verbose);
@@ -483,8 +661,6 @@ namespace snapper
     void
     TheBigThings::probe_source(const BackupConfig& backup_config, bool verbose)
     {
-	const Shell shell_source = backup_config.get_source_shell();
-
 	// Query snapshots on source from snapperd.
 
 	if (verbose)
@@ -495,31 +671,46 @@ namespace snapper
 	if (verbose)
 	    cout << _("Probing extra information for source snapshots.") << endl;
 
+	// Query additional information (uuids, read-only, checksum of info.xml) for all
+	// snapshots at once. The source is always local.
+
+	vector<string> names;
+
+	for (const ProxySnapshot& source_snapshot : source_snapshots)
+	{
+	    if (source_snapshot.getNum() != 0)
+		names.push_back(to_string(source_snapshot.getNum()));
+	}
+
+	const vector<ProbedSnapshot> probed_snapshots =
+	    probe_local(snapper->getConfig().getSubvolume() + "/" SNAPSHOTS_NAME, names);
+
+	vector<ProbedSnapshot>::const_iterator probed_snapshot = probed_snapshots.begin();
+
 	for (const ProxySnapshot& source_snapshot : source_snapshots)
 	{
 	    unsigned int num = source_snapshot.getNum();
 	    if (num == 0)
 		continue;
 
-	    // Query additional information (uuids, read-only) from btrfs.
+	    const ProbedSnapshot& extra = *probed_snapshot++;
 
-	    CmdBtrfsSubvolumeShow extra(BTRFS_BIN, shell_source,
-	                                source_snapshot_dir(snapper, num) +
-	                                    "/" SNAPSHOT_NAME);
+	    if (!extra.has_subvolume)
+		SN_THROW(Exception(sformat("probing subvolume of snapshot %d failed", num)));
 
 	    TheBigThing the_big_thing(num);
 	    the_big_thing.date = source_snapshot.getDate();
-	    the_big_thing.source_state = extra.is_read_only() ? TheBigThing::SourceState::READ_ONLY :
+	    the_big_thing.source_state = extra.read_only ? TheBigThing::SourceState::READ_ONLY :
 		TheBigThing::SourceState::READ_WRITE;
-	    the_big_thing.source_uuid = extra.get_uuid();
-	    the_big_thing.source_parent_uuid = extra.get_parent_uuid();
-	    the_big_thing.source_received_uuid = extra.get_received_uuid();
-	    the_big_thing.source_creation_time = extra.get_creation_time();
+	    the_big_thing.source_uuid = extra.uuid;
+	    the_big_thing.source_parent_uuid = extra.parent_uuid;
+	    the_big_thing.source_received_uuid = extra.received_uuid;
+	    the_big_thing.source_creation_time = extra.creation_time;
 
-	    // Get the checksum of info.xml.
-	    CmdChecksum cmd_checksum(shell_source, SHA256SUM_BIN,
-				     source_snapshot_dir(snapper, num) + "/info.xml");
-	    the_big_thing.source_meta_checksum = cmd_checksum.get_checksum();
+	    if (!extra.has_checksum)
+		SN_THROW(Exception(_("Failed to compute checksum.")));
+
+	    the_big_thing.source_meta_checksum = extra.checksum;
 
 	    the_big_things.push_back(the_big_thing);
 	}
@@ -529,24 +720,58 @@ namespace snapper
     void
     TheBigThings::probe_target(const BackupConfig& backup_config, bool verbose)
     {
-	const Shell shell_target = backup_config.get_target_shell();
+	// Query snapshots on target including additional information (received-uuid,
+	// read-only, checksum of info.xml). For a remote target a single command is
+	// used for all snapshots. Snapshots found in the state cache are only listed.
 
-	// Query snapshots on target from btrfs.
+	const bool full_probe = state_cache.needs_full_probe();
+	const map<string, ProbedSnapshot>& known = state_cache.get_target_snapshots();
 
 	if (verbose)
-	    cout << _("Probing target snapshots.") << endl;
+	{
+	    if (full_probe)
+		cout << _("Probing target snapshots.") << endl;
+	    else
+		cout << _("Probing target snapshots not in state cache.") << endl;
+	}
+
+	vector<ProbedSnapshot> probed_snapshots;
+
+	switch (backup_config.target_mode)
+	{
+	    case BackupConfig::TargetMode::LOCAL:
+	    {
+		vector<string> names;
 
-	/* Using 'btrfs subvolume list' instead of 'ls' is much more complicated. */
+		for (const string& name : list_local(backup_config.target_path))
+		{
+		    map<string, ProbedSnapshot>::const_iterator it = known.find(name);
+		    if (it != known.end())
+			probed_snapshots.push_back(it->second);
+		    else
+			names.push_back(name);
+		}
 
-	CmdLs cmd_ls(backup_config.target_ls_bin, shell_target, backup_config.target_path);
+		const vector<ProbedSnapshot> tmp = probe_local(backup_config.target_path, names);
+		probed_snapshots.insert(probed_snapshots.end(), tmp.begin(), tmp.end());
+	    }
+	    break;
 
-	if (verbose)
-	    cout << _("Probing extra information for target snapshots.") << endl;
+	    case BackupConfig::TargetMode::SSH_PUSH:
+		probed_snapshots = probe_remote(backup_config.get_target_shell(), backup_config.target_path,
+						backup_config.target_ls_bin, backup_config.target_btrfs_bin,
+						backup_config.target_sha256sum_bin, known);
+		break;
+	}
+
+	state_cache.update(probed_snapshots, full_probe);
 
 	static const regex num_regex("[0-9]+", regex::extended);
 
-	for (const string& num_string : cmd_ls)
+	for (const ProbedSnapshot& extra : probed_snapshots)
 	{
+	    const string& num_string = extra.name;
+
 	    if (!regex_match(num_string, num_regex))
 	    {
 		string error = sformat(_("Invalid subvolume path '%s' on target."), num_string.c_str());
@@ -556,117 +781,311 @@ namespace snapper
 	    unsigned int num = stoi(num_string);
 	    vector<TheBigThing>::iterator it = find(num);
 
-	    // Query additional information (receive-uuid, read-only) from btrfs.
+	    // If the subvolume is missing target_state is plain and simply missing and
+	    // an interrupted transfer is resumed. If the snapshot is also missing on
+	    // the source the directory, e.g. with a partial stream file, is left over
+	    // and must be deleted.
 
-	    try
+	    if (!extra.has_subvolume)
 	    {
-		CmdBtrfsSubvolumeShow extra(backup_config.target_btrfs_bin, shell_target, backup_config.target_path +
-					    "/" + num_string + "/" SNAPSHOT_NAME);
-
-		bool is_read_only = extra.is_read_only();
-		if (!is_read_only)
+		if (it == end())
 		{
-		    y2deb(num << " not read-only, maybe interrupted transfer");
+		    y2deb(num << " no subvolume, maybe interrupted transfer");
+
+		    TheBigThing the_big_thing(num);
+		    the_big_thing.target_state = TheBigThing::TargetState::INVALID;
+		    the_big_things.push_back(the_big_thing);
 		}
 
-		if (it != end())
-		{
-		    // Wrong receive-uuid can happen when a snapshots is transferred, then removed
-		    // and a new one with the same number is generated.
+		continue;
+	    }
 
-		    // When a snapshot is restored using btrfs send and receive the received
-		    // uuid of the source is identical to the received uuid of the target -
-		    // not the uuid of the target. In that case the target is also valid.
+	    bool is_read_only = extra.read_only;
+	    if (!is_read_only)
+	    {
+		y2deb(num << " not read-only, maybe interrupted transfer");
+	    }
+
+	    if (it != end())
+	    {
+		// Wrong receive-uuid can happen when a snapshots is transferred, then removed
+		// and a new one with the same number is generated.
+
+		// When a snapshot is restored using btrfs send and receive the received
+		// uuid of the source is identical to the received uuid of the target -
+		// not the uuid of the target. In that case the target is also valid.
 
-		    bool correct_uuid = false;
+		bool correct_uuid = false;
 
-		    if (!extra.get_received_uuid().empty())
+		if (!extra.received_uuid.empty())
+		{
+		    if (it->source_uuid == extra.received_uuid)
+			correct_uuid = true;
+		    else if (it->source_received_uuid == extra.received_uuid)
+			correct_uuid = true;
+
+		    if (!correct_uuid)
 		    {
-			if (it->source_uuid == extra.get_received_uuid())
-			    correct_uuid = true;
-			else if (it->source_received_uuid == extra.get_received_uuid())
-			    correct_uuid = true;
-
-			if (!correct_uuid)
-			{
-			    y2deb(num << " wrong uuid, maybe snapshot number reuse");
-			}
+			y2deb(num << " wrong uuid, maybe snapshot number reuse");
 		    }
-
-		    if (correct_uuid && is_read_only)
-			it->target_state = TheBigThing::TargetState::VALID;
-		    else
-			it->target_state = TheBigThing::TargetState::INVALID;
 		}
+
+		if (correct_uuid && is_read_only)
+		    it->target_state = TheBigThing::TargetState::VALID;
 		else
-		{
-		    TheBigThing the_big_thing(num);
+		    it->target_state = TheBigThing::TargetState::INVALID;
+	    }
+	    else
+	    {
+		TheBigThing the_big_thing(num);
 
-		    // Cannot check received-uuid so assume valid.
+		// Cannot check received-uuid so assume valid.
 
-		    if (is_read_only)
-			the_big_thing.target_state = TheBigThing::TargetState::VALID;
-		    else
-			the_big_thing.target_state = TheBigThing::TargetState::INVALID;
+		if (is_read_only)
+		    the_big_thing.target_state = TheBigThing::TargetState::VALID;
+		else
+		    the_big_thing.target_state = TheBigThing::TargetState::INVALID;
 
-		    it = the_big_things.insert(the_big_things.end(), the_big_thing);
-		}
+		it = the_big_things.insert(the_big_things.end(), the_big_thing);
+	    }
 
-		it->target_uuid = extra.get_uuid();
-		it->target_parent_uuid = extra.get_parent_uuid();
-		it->target_received_uuid = extra.get_received_uuid();
-		it->target_creation_time = extra.get_creation_time();
+	    it->target_uuid = extra.uuid;
+	    it->target_parent_uuid = extra.parent_uuid;
+	    it->target_received_uuid = extra.received_uuid;
+	    it->target_creation_time = extra.creation_time;
 
-		try
-		{
-		    // Get the checksum of info.xml.
-		    CmdChecksum cmd_checksum(shell_target, backup_config.target_sha256sum_bin,
-					     target_snapshot_dir(backup_config, num) + "/info.xml");
-		    it->target_meta_checksum = cmd_checksum.get_checksum();
-		}
-		catch (const Exception& e)
-		{
-		    SN_CAUGHT(e);
+	    // keep checksum empty if it could not be computed
+	    it->target_meta_checksum = extra.checksum;
 
-		    // keep checksum empty
-		}
+	    if (it->source_state == TheBigThing::SourceState::READ_ONLY &&
+		it->target_state == TheBigThing::TargetState::VALID &&
+		it->source_meta_checksum != it->target_meta_checksum)
+	    {
+		it->target_state = TheBigThing::TargetState::LEGACY;
+	    }
+	}
+    }
+
+
+    void
+    TheBigThings::transfer(const BackupConfig& backup_config, bool quiet, bool verbose,
+			   unsigned int jobs)
+    {
+	// Invalid snapshots on the target are replaced. Delete them all at once.
+
+	vector<TheBigThing*> invalid;
+
+	for (TheBigThing& the_big_thing : the_big_things)
+	{
+	    if (the_big_thing.source_state == TheBigThing::SourceState::READ_ONLY &&
+		the_big_thing.target_state == TheBigThing::TargetState::INVALID)
+		invalid.push_back(&the_big_thing);
+	}
+
+	if (!invalid.empty())
+	    remove_snapshots(backup_config, invalid, quiet);
 
-		if (it->source_state == TheBigThing::SourceState::READ_ONLY &&
-		    it->target_state == TheBigThing::TargetState::VALID &&
-		    it->source_meta_checksum != it->target_meta_checksum)
+	if (jobs > 1)
+	{
+	    transfer_parallel(backup_config, quiet, jobs);
+	    return;
+	}
+
+	for (TheBigThing& the_big_thing : the_big_things)
+	{
+	    if (the_big_thing.source_state == TheBigThing::SourceState::READ_ONLY)
+	    {
+		if (the_big_thing.target_state == TheBigThing::TargetState::MISSING ||
+		    the_big_thing.target_state == TheBigThing::TargetState::LEGACY)
 		{
-		    it->target_state = TheBigThing::TargetState::LEGACY;
+		    the_big_thing.transfer(backup_config, *this, quiet);
 		}
 	    }
-	    catch (const Exception& e)
-	    {
-		SN_CAUGHT(e);
-
-		// target_state is plain and simply missing or the snapshot is not even in
-		// the list.
-	    }
 	}
     }
 
 
+    namespace
+    {
+
+	struct TransferTask
+	{
+	    enum class State { WAITING, RUNNING, DONE, FAILED, SKIPPED };
+
+	    TransferTask(TheBigThing* the_big_thing) : the_big_thing(the_big_thing) {}
+
+	    TheBigThing* the_big_thing;
+
+	    // The task transferring the send parent, if any.
+	    const TransferTask* parent = nullptr;
+
+	    State state = State::WAITING;
+	};
+
+    }
+
+
     void
-    TheBigThings::transfer(const BackupConfig& backup_config, bool quiet, bool verbose)
+    TheBigThings::transfer_parallel(const BackupConfig& backup_config, bool quiet,
+				    unsigned int jobs)
     {
+	// Build the tasks in the same order as a sequential transfer. The send parent
+	// of a snapshot is the nearest snapshot that is either already valid or
+	// transferred by a previous task. In the latter case the task must wait for
+	// the previous task. A metadata update does not need a send parent.
+
+	vector<TransferTask> tasks;
+	tasks.reserve(the_big_things.size());
+
+	map<unsigned int, const TransferTask*> pending;
+
 	for (TheBigThing& the_big_thing : the_big_things)
 	{
-	    if (the_big_thing.source_state == TheBigThing::SourceState::READ_ONLY)
+	    if (the_big_thing.source_state != TheBigThing::SourceState::READ_ONLY)
+		continue;
+
+	    if (the_big_thing.target_state == TheBigThing::TargetState::MISSING)
+	    {
+		TransferTask task(&the_big_thing);
+
+		auto parent = source_tree.find_nearest_node(the_big_thing.source_uuid,
+		    [&pending](const TreeView::ProxyNode* node) {
+			return node->is_valid() ||
+			    (!node->is_virtual() && pending.count(node->get_number()) != 0);
+		    });
+
+		if (parent && !parent->node->is_valid())
+		    task.parent = pending[parent->node->get_number()];
+
+		tasks.push_back(task);
+		pending[the_big_thing.num] = &tasks.back();
+	    }
+	    else if (the_big_thing.target_state == TheBigThing::TargetState::LEGACY)
 	    {
-		if (the_big_thing.target_state == TheBigThing::TargetState::INVALID)
+		tasks.emplace_back(&the_big_thing);
+	    }
+	}
+
+	if (tasks.empty())
+	    return;
+
+	// Query the supported protocol once before the threads use it.
+	proto();
+
+	boost::unique_lock<boost::mutex> lock(mutex);
+	boost::condition_variable condition;
+	boost::thread_group threads;
+
+	unsigned int running = 0;
+
+	while (true)
+	{
+	    for (TransferTask& task : tasks)
+	    {
+		if (task.state != TransferTask::State::WAITING)
+		    continue;
+
+		if (task.parent)
 		{
-		    the_big_thing.remove(backup_config, quiet);
+		    if (task.parent->state == TransferTask::State::FAILED ||
+			task.parent->state == TransferTask::State::SKIPPED)
+		    {
+			cerr << sformat(_("Skipping snapshot %d since transferring snapshot %d "
+					  "failed."), task.the_big_thing->num,
+					task.parent->the_big_thing->num) << endl;
+			task.state = TransferTask::State::SKIPPED;
+			continue;
+		    }
+
+		    if (task.parent->state != TransferTask::State::DONE)
+			continue;
 		}
 
-		if (the_big_thing.target_state == TheBigThing::TargetState::MISSING ||
-		    the_big_thing.target_state == TheBigThing::TargetState::LEGACY)
+		if (running == jobs)
+		    continue;
+
+		task.state = TransferTask::State::RUNNING;
+		++running;
+
+		auto worker = [this, &backup_config, quiet, &task, &running, &condition]() {
+
+		    bool ok = true;
+
+		    try
+		    {
+			task.the_big_thing->transfer(backup_config, *this, quiet);
+		    }
+		    catch (const Exception& e)
+		    {
+			SN_CAUGHT(e);
+
+			boost::lock_guard<boost::mutex> lock(mutex);
+
+			cerr << e.what() << '\n';
+			cerr << sformat(_("Transferring snapshot %d failed."),
+					task.the_big_thing->num) << endl;
+
+			ok = false;
+		    }
+		    catch (const std::exception& e)
+		    {
+			y2err("transferring snapshot " << task.the_big_thing->num << " failed, " << e.what());
+
+			boost::lock_guard<boost::mutex> lock(mutex);
+
+			cerr << e.what() << '\n';
+			cerr << sformat(_("Transferring snapshot %d failed."),
+					task.the_big_thing->num) << endl;
+
+			ok = false;
+		    }
+
+		    boost::lock_guard<boost::mutex> lock(mutex);
+
+		    task.state = ok ? TransferTask::State::DONE : TransferTask::State::FAILED;
+		    --running;
+
+		    condition.notify_one();
+
+		};
+
+		try
 		{
-		    the_big_thing.transfer(backup_config, *this, quiet);
+		    threads.create_thread(worker);
+		}
+		catch (...)
+		{
+		    // Let the running threads finish since they reference local
+		    // variables.
+
+		    task.state = TransferTask::State::FAILED;
+		    --running;
+
+		    lock.unlock();
+		    threads.join_all();
+
+		    throw;
 		}
 	    }
+
+	    if (running == 0)
+		break;
+
+	    condition.wait(lock);
+	}
+
+	lock.unlock();
+	threads.join_all();
+
+	unsigned int errors = count_if(tasks.begin(), tasks.end(), [](const TransferTask& task) {
+	    return task.state != TransferTask::State::DONE;
+	});
+
+	if (errors != 0)
+	{
+	    string error = sformat(_("Transferring %d of %ld snapshots failed."), errors,
+				   tasks.size());
+	    SN_THROW(Exception(error));
 	}
     }
 
@@ -688,18 +1107,156 @@ namespace snapper
     void
     TheBigThings::remove(const BackupConfig& backup_config, bool quiet, bool verbose)
     {
+	vector<TheBigThing*> snapshots;
+
 	for (TheBigThing& the_big_thing : the_big_things)
 	{
-	    if (the_big_thing.target_state == TheBigThing::TargetState::INVALID)
+	    if (the_big_thing.target_state == TheBigThing::TargetState::INVALID ||
+		(the_big_thing.source_state == TheBigThing::SourceState::MISSING &&
+		 the_big_thing.target_state != TheBigThing::TargetState::MISSING))
 	    {
-		the_big_thing.remove(backup_config, quiet);
+		snapshots.push_back(&the_big_thing);
 	    }
+	}
+
+	if (!snapshots.empty())
+	    remove_snapshots(backup_config, snapshots, quiet);
+    }
+
+
+    namespace
+    {
+
+	// Maximal number of snapshots deleted by one command. Only the numbers
+	// are passed as arguments so the command line stays short.
+	const size_t max_remove_batch = 1000;
 
-	    if (the_big_thing.source_state == TheBigThing::SourceState::MISSING &&
-		the_big_thing.target_state != TheBigThing::TargetState::MISSING)
+
+	const char*
+	remove_error(const string& result)
+	{
+	    if (result == "subvolume")
+		return _("'btrfs subvolume delete' failed.");
+	    else if (result == "stream")
+		return _("'rm stream' failed.");
+	    else if (result == "info")
+		return _("'rm info.xml' failed.");
+	    else if (result == "dir")
+		return _("'rmdir' failed.");
+
+	    return _("Running command on target failed.");
+	}
+
+    }
+
+
+    void
+    TheBigThings::remove_snapshots(const BackupConfig& backup_config,
+				   const vector<TheBigThing*>& snapshots, bool quiet)
+    {
+	// The script deletes all existing subvolumes with a single btrfs command.
+	// btrfs continues with the other subvolumes if one fails. Afterwards the
+	// stream file, the info.xml and the directory of every snapshot whose
+	// subvolume is gone are removed. The stream file and info.xml might be
+	// missing, e.g. after an interrupted transfer. For every snapshot a line
+	// with the result is printed. The output of the commands goes to stderr.
+
+	static const char* script =
+	    "dir=$1 btrfs=$2 rm=$3 rmdir=$4 stream=$5\n"
+	    "shift 5\n"
+	    "nums=$*\n"
+	    "set --\n"
+	    "for n in $nums; do\n"
+	    "    if [ -e \"$dir/$n/" SNAPSHOT_NAME "\" ]; then set -- \"$@\" \"$dir/$n/" SNAPSHOT_NAME "\"; fi\n"
+	    "done\n"
+	    "if [ $# -ne 0 ]; then \"$btrfs\" subvolume delete -- \"$@\" >&2; fi\n"
+	    "for n in $nums; do\n"
+	    "    if [ -e \"$dir/$n/" SNAPSHOT_NAME "\" ]; then\n"
+	    "        echo \"snbk-remove $n subvolume\"\n"
+	    "    elif ! \"$rm\" --force -- \"$dir/$n/$stream\" >&2; then\n"
+	    "        echo \"snbk-remove $n stream\"\n"
+	    "    elif ! \"$rm\" --force -- \"$dir/$n/info.xml\" >&2; then\n"
+	    "        echo \"snbk-remove $n info\"\n"
+	    "    elif ! \"$rmdir\" -- \"$dir/$n\" >&2; then\n"
+	    "        echo \"snbk-remove $n dir\"\n"
+	    "    else\n"
+	    "        echo \"snbk-remove $n ok\"\n"
+	    "    fi\n"
+	    "done\n";
+
+	static const regex result_regex("snbk-remove ([0-9]+) ([a-z]+)", regex::extended);
+
+	unsigned int errors = 0;
+
+	for (size_t pos = 0; pos < snapshots.size(); pos += max_remove_batch)
+	{
+	    const vector<TheBigThing*> batch(snapshots.begin() + pos, snapshots.begin() +
+					     min(pos + max_remove_batch, snapshots.size()));
+
+	    vector<unsigned int> nums;
+
+	    for (const TheBigThing* the_big_thing : batch)
+	    {
+		if (!quiet)
+		    cout << sformat(_("Deleting snapshot %d."), the_big_thing->num) << '\n';
+
+		nums.push_back(the_big_thing->num);
+	    }
+
+	    state_cache.erase(nums);
+
+	    SystemCmd::Args cmd_args = { SH_BIN, "-c", script, "snbk-remove", backup_config.target_path,
+		backup_config.target_btrfs_bin, backup_config.target_rm_bin, backup_config.target_rmdir_bin,
+		stream_file_name };
+
+	    for (unsigned int num : nums)
+		cmd_args << to_string(num);
+
+	    SystemCmd cmd(shellify(backup_config.get_target_shell(), cmd_args));
+
+	    map<unsigned int, string> results;
+
+	    smatch match;
+
+	    for (const string& line : cmd.get_stdout())
 	    {
-		the_big_thing.remove(backup_config, quiet);
+		if (regex_match(line, match, result_regex))
+		    results[stoi(match[1])] = match[2];
 	    }
+
+	    bool failed = false;
+
+	    for (TheBigThing* the_big_thing : batch)
+	    {
+		map<unsigned int, string>::const_iterator it = results.find(the_big_thing->num);
+
+		if (it != results.end() && it->second == "ok")
+		{
+		    the_big_thing->target_state = TheBigThing::TargetState::MISSING;
+		    continue;
+		}
+
+		cerr << remove_error(it != results.end() ? it->second : "") << '\n';
+		cerr << sformat(_("Deleting snapshot %d failed."), the_big_thing->num) << endl;
+
+		failed = true;
+		++errors;
+	    }
+
+	    if (failed || cmd.retcode() != 0)
+	    {
+		y2err("command '" << cmd.cmd() << "' failed: " << cmd.retcode());
+		for (const string& tmp : cmd.get_stdout())
+		    y2err(tmp);
+		for (const string& tmp : cmd.get_stderr())
+		    y2err(tmp);
+	    }
+	}
+
+	if (errors != 0)
+	{
+	    string error = sformat(_("Deleting %d of %ld snapshots failed."), errors, snapshots.size());
+	    SN_THROW(Exception(error));
 	}
     }
 
@@ -26,11 +26,15 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include <memory>
+#include <boost/thread/mutex.hpp>
 
 #include "../proxy/proxy.h"
 #include "../proxy/locker.h"
 
+#include "BackupLock.h"
 #include "CmdBtrfs.h"
+#include "StateCache.h"
 #include "TreeView.h"
 
 
@@ -71,7 +75,7 @@ namespace snapper
 	void transfer(const BackupConfig& backup_config, TheBigThings& the_big_things, bool quiet);
 	void restore(const BackupConfig& backup_config, TheBigThings& the_big_things, bool quiet);
 
-	void remove(const BackupConfig& backup_config, bool quiet);
+	void remove(const BackupConfig& backup_config, TheBigThings& the_big_things, bool quiet);
 
 	unsigned int num;
 	time_t date = 0;	// as reported by snapper
@@ -113,9 +117,16 @@ namespace snapper
 	    Shell shell;
 	    string mkdir_bin;
 	    string btrfs_bin;
+	    string zstd_bin;
 	    string remote_host;
 	    string snapshot_dir;
 	    string parent_subvol_path;
+
+	    /**
+	     * If not empty the stream is saved in this file on the destination
+	     * before it is received.
+	     */
+	    string stream_file;
 	};
 
 	/**
@@ -128,7 +139,7 @@ namespace snapper
 	                                         CopyMode copy_mode) const;
 
 	void copy(const BackupConfig& backup_config, TheBigThings& the_big_things,
-	          const pair<CopySpec, CopySpec>& copy_specs);
+	          const pair<CopySpec, CopySpec>& copy_specs, bool quiet);
 	void copy_metadata(const BackupConfig& backup_config,
 	                   TheBigThings& the_big_things,
 	                   const pair<CopySpec, CopySpec>& copy_specs);
@@ -143,19 +154,53 @@ namespace snapper
 
     class TheBigThings
     {
+    private:
+
+	/**
+	 * The lock for the backup config. Taken before anything else.
+	 */
+	const BackupLock backup_lock;
+
+	/**
+	 * The ssh session for the target. Must be started before anything copies the
+	 * target shell.
+	 */
+	const std::shared_ptr<SshSession> ssh_session;
+
     public:
 
 	/**
 	 * Queries the snapshots on the source and target. Also gets a ProxySnapper and
-	 * locks it.
+	 * locks it. Before that waits until the backup config can be locked with the
+	 * given mode. For a remote target an ssh session is started that is used for
+	 * all commands on the target. Snapshots on the target found in the state cache
+	 * are not probed.
 	 */
-	TheBigThings(const BackupConfig& backup_config, ProxySnappers* snappers, bool verbose);
+	TheBigThings(const BackupConfig& backup_config, ProxySnappers* snappers,
+		     BackupLock::Mode lock_mode, bool verbose);
 
-	void transfer(const BackupConfig& backup_config, bool quiet, bool verbose);
+	/**
+	 * Transfers all missing snapshots. With more than one job, snapshots that do
+	 * not depend on each other as Btrfs send parents are transferred in parallel.
+	 * If a transfer fails, the snapshots depending on it are skipped while the
+	 * other transfers continue.
+	 */
+	void transfer(const BackupConfig& backup_config, bool quiet, bool verbose,
+		      unsigned int jobs);
 	void restore(const BackupConfig& backup_config, bool quiet, bool verbose);
 
 	void remove(const BackupConfig& backup_config, bool quiet, bool verbose);
 
+	/**
+	 * Deletes the snapshots on the target. All subvolumes are deleted with a
+	 * single btrfs command and the remaining files and directories with a
+	 * single shell, so for a remote target only one ssh command is needed for
+	 * many snapshots. The other snapshots are still deleted if deleting one
+	 * fails. Afterwards an exception is thrown if any snapshot failed.
+	 */
+	void remove_snapshots(const BackupConfig& backup_config, const vector<TheBigThing*>& snapshots,
+			      bool quiet);
+
 	typedef vector<TheBigThing>::iterator iterator;
 	typedef vector<TheBigThing>::const_iterator const_iterator;
 
@@ -181,6 +226,18 @@ namespace snapper
 
 	const ProxySnapper* snapper;
 
+	/**
+	 * Protects the states of the snapshots and the snapper during a parallel
+	 * transfer.
+	 */
+	boost::mutex mutex;
+
+	/**
+	 * Cache of the probed snapshots on the target. Snapshots must be erased
+	 * from it before they are modified on the target.
+	 */
+	StateCache state_cache;
+
     private:
 
 	const Locker locker;
@@ -190,6 +247,9 @@ namespace snapper
 	void probe_source(const BackupConfig& backup_config, bool verbose);
 	void probe_target(const BackupConfig& backup_config, bool verbose);
 
+	void transfer_parallel(const BackupConfig& backup_config, bool quiet,
+			       unsigned int jobs);
+
     };
 
 }
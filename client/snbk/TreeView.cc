@@ -232,11 +232,21 @@ namespace snapper
 
     std::optional<TreeView::SearchResult>
     TreeView::find_nearest_valid_node(const string& start_uuid) const
+    {
+	return find_nearest_node(start_uuid, [](const ProxyNode* node) {
+	    return node->is_valid();
+	});
+    }
+
+
+    std::optional<TreeView::SearchResult>
+    TreeView::find_nearest_node(const string& start_uuid,
+                                const function<bool(const ProxyNode*)>& predicate) const
     {
 	auto pair = pool.find(start_uuid);
 	if (pair != pool.end())
 	{
-	    return find_nearest_valid_node(pair->second.get());
+	    return find_nearest_node(pair->second.get(), predicate);
 	}
 
 	SN_THROW(Exception(
@@ -246,7 +256,8 @@ namespace snapper
 
 
     std::optional<TreeView::SearchResult>
-    TreeView::find_nearest_valid_node(const ProxyNode* start_node) const
+    TreeView::find_nearest_node(const ProxyNode* start_node,
+                                const function<bool(const ProxyNode*)>& predicate) const
     {
 	queue<SearchResult> nodes_to_visit;
 	unordered_set<string> visited;
@@ -260,8 +271,8 @@ namespace snapper
 	    nodes_to_visit.pop();
 
 	    // Return the current search result if the distance is > 0
-	    // (i.e., not the start node) and it is valid.
-	    if (current.distance > 0 && current.node->is_valid())
+	    // (i.e., not the start node) and the predicate holds.
+	    if (current.distance > 0 && predicate(current.node))
 	    {
 		return current;
 	    }
@@ -23,6 +23,7 @@
 #define SNAPPER_SNBK_TREE_VIEW_H
 
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -111,6 +112,14 @@ namespace snapper
 	std::optional<SearchResult>
 	find_nearest_valid_node(const string& start_uuid) const;
 
+	/**
+	 * Find the nearest node for which the predicate holds. The search order is the
+	 * same as for find_nearest_valid_node().
+	 */
+	std::optional<SearchResult>
+	find_nearest_node(const string& start_uuid,
+	                  const std::function<bool(const ProxyNode*)>& predicate) const;
+
 	/** Print the tree graph in Graphviz DOT Language. */
 	void print_graph_graphviz(const Rankdir rankdir = Rankdir::LR) const;
 
@@ -136,11 +145,12 @@ namespace snapper
 	};
 
 	/**
-	 * Find the nearest valid node to use as a Btrfs‑send parent, starting from the
-	 * given node.
+	 * Find the nearest node for which the predicate holds, starting from the given
+	 * node.
 	 */
 	std::optional<SearchResult>
-	find_nearest_valid_node(const ProxyNode* start_node) const;
+	find_nearest_node(const ProxyNode* start_node,
+	                  const std::function<bool(const ProxyNode*)>& predicate) const;
 
 	/**
 	 * Print the tree graph in Graphviz DOT Language, starting from the given node.
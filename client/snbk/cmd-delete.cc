@@ -54,7 +54,7 @@ namespace snapper
 	    void run_single(TheBigThing& the_big_thing, const BackupConfig& backup_config,
 	                    TheBigThings& the_big_things, bool quiet) const override
 	    {
-		the_big_thing.remove(backup_config, quiet);
+		the_big_thing.remove(backup_config, the_big_things, quiet);
 	    }
 
 	    const char* msg_running() const override
@@ -237,7 +237,8 @@ namespace snapper
 
 		try
 		{
-		    TheBigThings the_big_things(backup_config, snappers, global_options.verbose());
+		    TheBigThings the_big_things(backup_config, snappers, BackupLock::Mode::SHARED,
+						global_options.verbose());
 
 		    TableFormatter formatter(global_options.table_style());
 
@@ -300,7 +301,8 @@ namespace snapper
 
 	    for (const BackupConfig& backup_config : backup_configs)
 	    {
-		TheBigThings the_big_things(backup_config, snappers, global_options.verbose());
+		TheBigThings the_big_things(backup_config, snappers, BackupLock::Mode::SHARED,
+					    global_options.verbose());
 
 		for (const TheBigThing& the_big_thing : the_big_things)
 		{
@@ -330,7 +332,8 @@ namespace snapper
 
 	    for (const BackupConfig& backup_config : backup_configs)
 	    {
-		TheBigThings the_big_things(backup_config, snappers, global_options.verbose());
+		TheBigThings the_big_things(backup_config, snappers, BackupLock::Mode::SHARED,
+					    global_options.verbose());
 
 		for (const TheBigThing& the_big_thing : the_big_things)
 		{
@@ -22,6 +22,7 @@
 
 #include <iostream>
 
+#include "../utils/help.h"
 #include "../utils/text.h"
 
 #include "utils.h"
@@ -47,6 +48,20 @@ namespace snapper
 
 	    const char* command() const override { return "transfer-and-delete"; }
 
+	    const vector<Option>& options() const override
+	    {
+		static const vector<Option> options = {
+		    Option("jobs",	required_argument,	'j')
+		};
+
+		return options;
+	    }
+
+	    void evaluate_options(const ParsedOpts& opts) override
+	    {
+		jobs = parse_jobs(opts);
+	    }
+
 	    void prerequisite() const override
 	    {
 		if (get_opts.has_args())
@@ -60,7 +75,7 @@ namespace snapper
 	                 bool quiet, bool verbose) const override
 	    {
 		the_big_things.transfer(backup_config, global_options.quiet(),
-		                        global_options.quiet());
+		                        global_options.quiet(), jobs);
 		the_big_things.remove(backup_config, global_options.quiet(),
 		                      global_options.quiet());
 	    }
@@ -89,6 +104,10 @@ namespace snapper
 		    "Running transfer and delete failed for %d of %ld backup configs.",
 		    backup_configs.size());
 	    }
+
+	private:
+
+	    unsigned int jobs = 1;
 	};
 
     } // namespace
@@ -100,8 +119,13 @@ namespace snapper
     help_transfer_and_delete()
     {
 	cout << "  " << _("Transfer and delete:") << '\n'
-	     << "\t" << _("snbk transfer-and-delete") << '\n'
-	     << '\n';
+	     << "\t" << _("snbk transfer-and-delete [options]") << '\n'
+	     << '\n'
+	     << "    " << _("Options for the 'transfer-and-delete' command:") << '\n';
+
+	print_options({
+	    { _("--jobs, -j <number>"), _("Number of snapshots transferred in parallel.") }
+	});
     }
 
 
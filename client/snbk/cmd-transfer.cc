@@ -22,6 +22,7 @@
 
 #include <iostream>
 
+#include "../utils/help.h"
 #include "../utils/text.h"
 
 #include "utils.h"
@@ -45,10 +46,24 @@ namespace snapper
 
 	    const char* command() const override { return "transfer"; }
 
+	    const vector<Option>& options() const override
+	    {
+		static const vector<Option> options = {
+		    Option("jobs",	required_argument,	'j')
+		};
+
+		return options;
+	    }
+
+	    void evaluate_options(const ParsedOpts& opts) override
+	    {
+		jobs = parse_jobs(opts);
+	    }
+
 	    void run_all(TheBigThings& the_big_things, const BackupConfig& backup_config,
 	                 bool quiet, bool verbose) const override
 	    {
-		the_big_things.transfer(backup_config, quiet, verbose);
+		the_big_things.transfer(backup_config, quiet, verbose, jobs);
 	    }
 
 	    void run_single(TheBigThing& the_big_thing, const BackupConfig& backup_config,
@@ -73,6 +88,10 @@ namespace snapper
 		         "Running transfer failed for %d of %ld backup configs.",
 		         backup_configs.size());
 	    }
+
+	private:
+
+	    unsigned int jobs = 1;
 	};
 
     } // namespace
@@ -84,8 +103,13 @@ namespace snapper
     help_transfer()
     {
 	cout << "  " << _("Transfer:") << '\n'
-	     << "\t" << _("snbk transfer [numbers]") << '\n'
-	     << '\n';
+	     << "\t" << _("snbk transfer [options] [numbers]") << '\n'
+	     << '\n'
+	     << "    " << _("Options for the 'transfer' command:") << '\n';
+
+	print_options({
+	    { _("--jobs, -j <number>"), _("Number of snapshots transferred in parallel.") }
+	});
     }
 
 
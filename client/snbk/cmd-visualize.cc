@@ -120,7 +120,7 @@ namespace snapper
 
 	// Execute command
 	const BackupConfig& backup_config = backup_configs.front();
-	TheBigThings the_big_things(backup_config, snappers, false);
+	TheBigThings the_big_things(backup_config, snappers, BackupLock::Mode::SHARED, false);
 
 	switch (mode)
 	{
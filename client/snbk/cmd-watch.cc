@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include <iostream>
+#include <chrono>
+#include <regex>
+#include <memory>
+
+#include "snapper/AppUtil.h"
+#include "snapper/LoggerImpl.h"
+
+#include "dbus/DBusConnection.h"
+#include "dbus/DBusMessage.h"
+
+#include "../utils/help.h"
+#include "../utils/text.h"
+#include "../proxy/errors.h"
+#include "../proxy/proxy.h"
+
+#include "BackupConfig.h"
+#include "GlobalOptions.h"
+#include "TheBigThing.h"
+
+
+#define SERVICE "org.opensuse.Snapper"
+#define OBJECT "/org/opensuse/Snapper"
+#define INTERFACE "org.opensuse.Snapper"
+
+
+namespace snapper
+{
+
+    using namespace std;
+    using namespace std::chrono;
+
+
+    namespace
+    {
+
+	// Delay before a failed transfer is retried.
+	const seconds retry_delay = minutes(5);
+
+	// A burst of snapshots postpones the transfer by at most this factor of
+	// the delay.
+	const unsigned int max_delay_factor = 5;
+
+
+	struct Pending
+	{
+	    steady_clock::time_point first;
+	    steady_clock::time_point deadline;
+	};
+
+
+	unsigned int
+	parse_delay(const ParsedOpts& opts)
+	{
+	    static const regex delay_regex("[0-9]{1,5}", regex::extended);
+
+	    ParsedOpts::const_iterator opt = opts.find("delay");
+	    if (opt == opts.end())
+		return 10;
+
+	    if (!regex_match(opt->second, delay_regex))
+	    {
+		string error = sformat(_("Invalid delay '%s'."), opt->second.c_str());
+		SN_THROW(OptionsException(error));
+	    }
+
+	    return stoi(opt->second);
+	}
+
+
+	// Transfers the snapshots for all backup configs of the snapper config.
+	// Returns false if any transfer failed.
+	bool
+	transfer(const GlobalOptions& global_options, const vector<const BackupConfig*>& backup_configs,
+		 const string& config_name)
+	{
+	    // The proxy caches the snapshots so a new one is needed every time.
+	    ProxySnappers snappers = ProxySnappers::createDbus();
+
+	    bool ok = true;
+
+	    for (const BackupConfig* backup_config : backup_configs)
+	    {
+		if (backup_config->config != config_name)
+		    continue;
+
+		if (!global_options.quiet())
+		    cout << sformat(_("Running transfer for backup config '%s'."), backup_config->name.c_str())
+			 << endl;
+
+		try
+		{
+		    TheBigThings the_big_things(*backup_config, &snappers, BackupLock::Mode::EXCLUSIVE,
+						global_options.verbose());
+
+		    the_big_things.transfer(*backup_config, global_options.quiet(), global_options.verbose(), 1);
+		}
+		catch (const DBus::ErrorException& e)
+		{
+		    SN_CAUGHT(e);
+
+		    cerr << error_description(e) << endl;
+
+		    ok = false;
+		}
+		catch (const Exception& e)
+		{
+		    SN_CAUGHT(e);
+
+		    cerr << e.what() << '\n';
+		    cerr << sformat(_("Running transfer for backup config '%s' failed."),
+				    backup_config->name.c_str()) << endl;
+
+		    ok = false;
+		}
+	    }
+
+	    return ok;
+	}
+
+    }
+
+
+    void
+    help_watch()
+    {
+	cout << "  " << _("Watch:") << '\n'
+	     << "\t" << _("snbk watch [options]") << '\n'
+	     << '\n'
+	     << "    " << _("Options for the 'watch' command:") << '\n';
+
+	print_options({
+	    { _("--delay <seconds>"), _("Seconds to wait for further snapshots before a transfer.") }
+	});
+    }
+
+
+    void
+    command_watch(const GlobalOptions& global_options, GetOpts& get_opts, const BackupConfigs& backup_configs,
+		  ProxySnappers* snappers)
+    {
+	const vector<Option> options = {
+	    Option("delay",	required_argument)
+	};
+
+	ParsedOpts opts = get_opts.parse("watch", options);
+
+	if (get_opts.has_args())
+	{
+	    SN_THROW(OptionsException(_("Command 'watch' does not take arguments.")));
+	}
+
+	const seconds delay(parse_delay(opts));
+
+	if (global_options.no_dbus())
+	    SN_THROW(OptionsException(_("Command 'watch' requires DBus.")));
+
+	vector<const BackupConfig*> automatic_backup_configs;
+
+	for (const BackupConfig& backup_config : backup_configs)
+	{
+	    if (backup_config.automatic)
+		automatic_backup_configs.push_back(&backup_config);
+	}
+
+	if (automatic_backup_configs.empty())
+	    SN_THROW(Exception(_("No backup configs with automatic set found.")));
+
+	// Subscribe to the signals before the first transfer so that no snapshot
+	// is missed.
+
+	DBus::Connection conn(DBUS_BUS_SYSTEM);
+	conn.add_match("type='signal', sender='" SERVICE "', path='" OBJECT "', interface='"
+		       INTERFACE "'");
+
+	// Snapper configs with snapshots to transfer. Initially all snapshots
+	// created since the last run are transferred.
+
+	map<string, Pending> pending;
+
+	for (const BackupConfig* backup_config : automatic_backup_configs)
+	{
+	    const steady_clock::time_point now = steady_clock::now();
+	    pending[backup_config->config] = { now, now };
+	}
+
+	while (true)
+	{
+	    for (map<string, Pending>::iterator it = pending.begin(); it != pending.end(); )
+	    {
+		if (it->second.deadline > steady_clock::now())
+		{
+		    ++it;
+		    continue;
+		}
+
+		const string config_name = it->first;
+		it = pending.erase(it);
+
+		if (!transfer(global_options, automatic_backup_configs, config_name))
+		{
+		    const steady_clock::time_point now = steady_clock::now();
+		    pending[config_name] = { now, now + retry_delay };
+		}
+	    }
+
+	    int timeout = -1;
+
+	    for (const map<string, Pending>::value_type& value : pending)
+	    {
+		milliseconds tmp = duration_cast<milliseconds>(value.second.deadline - steady_clock::now());
+		if (tmp < milliseconds::zero())
+		    tmp = milliseconds::zero();
+
+		if (timeout < 0 || tmp.count() < timeout)
+		    timeout = tmp.count();
+	    }
+
+	    std::optional<DBus::Message> msg = conn.read_message(timeout);
+	    if (!msg)
+		continue;
+
+	    if (!msg->is_signal(INTERFACE, "SnapshotCreated") && !msg->is_signal(INTERFACE, "SnapshotModified"))
+		continue;
+
+	    string config_name;
+	    dbus_uint32_t num = 0;
+
+	    try
+	    {
+		DBus::Unmarshaller unmarshaller(*msg);
+		unmarshaller >> config_name >> num;
+	    }
+	    catch (const DBus::Exception& e)
+	    {
+		SN_CAUGHT(e);
+		continue;
+	    }
+
+	    if (none_of(automatic_backup_configs.begin(), automatic_backup_configs.end(),
+			[&config_name](const BackupConfig* backup_config) {
+			    return backup_config->config == config_name;
+			}))
+		continue;
+
+	    y2mil("snapshot " << num << " of config " << config_name << " created or modified");
+
+	    // Wait for further snapshots, e.g. the post snapshot of a pre and post
+	    // pair, but not forever.
+
+	    const steady_clock::time_point now = steady_clock::now();
+
+	    map<string, Pending>::iterator it = pending.find(config_name);
+	    if (it == pending.end())
+		pending[config_name] = { now, now + delay };
+	    else
+		it->second.deadline = min(max(it->second.deadline, now + delay),
+					  it->second.first + max_delay_factor * delay);
+	}
+    }
+
+}
@@ -123,6 +123,10 @@ get_backup_configs(const GlobalOptions& global_options, const vector<string>& na
 	if (global_options.automatic() && !backup_config.automatic)
 	    continue;
 
+	// A full probe also refreshes the state cache.
+	if (global_options.full_probe())
+	    backup_config.state_cache_max_age = 0;
+
 	backup_configs.push_back(backup_config);
     }
 
@@ -152,6 +156,7 @@ main(int argc, char** argv)
 	Cmd("delete", { "remove", "rm" }, command_delete, help_delete, true),
 	Cmd("transfer-and-delete", command_transfer_and_delete, help_transfer_and_delete, true),
 	Cmd("visualize", command_visualize, help_visualize, true),
+	Cmd("watch", command_watch, help_watch, false),
     };
 
     try
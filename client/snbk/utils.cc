@@ -36,7 +36,8 @@ namespace snapper
 
     void SnapshotOperation::operator()()
     {
-	ParsedOpts opts = get_opts.parse(command(), GetOpts::no_options);
+	ParsedOpts opts = get_opts.parse(command(), options());
+	evaluate_options(opts);
 
 	// Run prerequisite step
 	prerequisite();
@@ -53,7 +54,7 @@ namespace snapper
 
 	    try
 	    {
-		TheBigThings the_big_things(backup_config, snappers,
+		TheBigThings the_big_things(backup_config, snappers, BackupLock::Mode::EXCLUSIVE,
 		                            global_options.verbose());
 
 		if (nums.empty())
@@ -123,4 +124,28 @@ namespace snapper
 	return nums;
     }
 
+
+    unsigned int
+    parse_jobs(const ParsedOpts& opts)
+    {
+	// Each job uses its own ssh session over the master connection and
+	// sshd allows 10 sessions per connection by default (MaxSessions).
+
+	static const unsigned int max_jobs = 10;
+
+	static const regex jobs_regex("[1-9][0-9]?", regex::extended);
+
+	ParsedOpts::const_iterator opt = opts.find("jobs");
+	if (opt == opts.end())
+	    return 1;
+
+	if (!regex_match(opt->second, jobs_regex) || stoul(opt->second) > max_jobs)
+	{
+	    string error = sformat(_("Invalid number of jobs '%s'."), opt->second.c_str());
+	    SN_THROW(OptionsException(error));
+	}
+
+	return stoi(opt->second);
+    }
+
 } // namespace snapper
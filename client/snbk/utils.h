@@ -48,6 +48,12 @@ namespace snapper
 	/** Command name of the snapshot operation. */
 	virtual const char* command() const = 0;
 
+	/** Options of the command. */
+	virtual const vector<Option>& options() const { return GetOpts::no_options; }
+
+	/** Evaluate the parsed options of the command. */
+	virtual void evaluate_options(const ParsedOpts& opts) {}
+
 	/** Run the optional prerequisite procedures for the snapshot operation. */
 	virtual void prerequisite() const {}
 
@@ -74,4 +80,11 @@ namespace snapper
 	ProxySnappers* snappers;
     };
 
+
+    /**
+     * Parse the value of the jobs option, at most 10. Returns 1 if the option
+     * is missing.
+     */
+    unsigned int parse_jobs(const ParsedOpts& opts);
+
 } // namespace snapper
@@ -26,8 +26,10 @@
 #include <cstdlib>
 #include <iostream>
 
-#include <snapper/SystemCmd.h>
 #include <snapper/SnapperDefines.h>
+#include <snapper/FileUtils.h>
+#include <snapper/BtrfsUtils.h>
+#include <boost/algorithm/string/join.hpp>
 
 #include "../utils/text.h"
 #include "../utils/GetOpts.h"
@@ -75,6 +77,8 @@ timeline(ProxySnappers* snappers, const map<string, string>& userdata)
 {
     bool ok = true;
 
+    vector<string> config_names;
+
     map<string, ProxyConfig> configs = snappers->getConfigs();
     for (const map<string, ProxyConfig>::value_type& value : configs)
     {
@@ -85,23 +89,35 @@ timeline(ProxySnappers* snappers, const map<string, string>& userdata)
 
 	cout << "Running timeline for '" << value.first << "'." << endl;
 
-	ProxySnapper* snapper = nullptr;
+	config_names.push_back(value.first);
+    }
 
-	if (!call_with_error_check([&snappers, &snapper, &value](){ snapper = snappers->getSnapper(value.first); }))
-	{
-	    cerr << "timeline for '" << value.first << "' failed." << endl;
-	    ok = false;
-	    continue;
-	}
+    if (config_names.empty())
+	return ok;
+
+    // The snapshots of all configs are created at once so that snapperd
+    // can create them concurrently.
+
+    SCD scd;
+    scd.description = "timeline";
+    scd.cleanup = "timeline";
+    scd.userdata = userdata;
 
-	SCD scd;
-	scd.description = "timeline";
-	scd.cleanup = "timeline";
-	scd.userdata = userdata;
+    // The proxy itself falls back to creating the snapshots one by one if
+    // snapperd does not know the batch method. Other failures are not
+    // retried since some snapshots might already have been created.
 
-	if (!call_with_error_check([snapper, scd](){ snapper->createSingleSnapshot(scd, report); }))
+    vector<unsigned int> nums(config_names.size(), 0);
+
+    call_with_error_check([&snappers, &config_names, &scd, &nums](){
+	nums = snappers->createSingleSnapshots(config_names, scd, report);
+    });
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	if (nums[i] == 0)
 	{
-	    cerr << "timeline for '" << value.first << "' failed." << endl;
+	    cerr << "timeline for '" << config_names[i] << "' failed." << endl;
 	    ok = false;
 	}
     }
@@ -110,6 +126,56 @@ timeline(ProxySnappers* snappers, const map<string, string>& userdata)
 }
 
 
+#ifdef ENABLE_BTRFS_QUOTA
+
+void
+clear_stale_qgroups(const string& general_dir)
+{
+    try
+    {
+	SDir dir(general_dir);
+
+	if (!BtrfsUtils::is_quota_enabled(dir.fd()))
+	    return;
+
+	cout << "Clearing stale qgroups of '" << general_dir << "'." << endl;
+
+	// This fails more often than not since qgroups of just deleted
+	// subvolume are busy. So do not set an error code here. Still log the
+	// failure to help people understand this stuff.
+
+	unsigned int failed = BtrfsUtils::qgroup_clear_stale(dir.fd());
+	if (failed > 0)
+	    cerr << "Clearing " << failed << " stale qgroups of '" << general_dir << "' failed." << endl;
+    }
+    catch (const exception& e)
+    {
+	cerr << "Clearing stale qgroups of '" << general_dir << "' failed (" << e.what() << ")." << endl;
+    }
+}
+
+#endif
+
+
+#ifdef ENABLE_BTRFS
+
+string
+general_dir_of(const ProxyConfig& proxy_config)
+{
+    string fstype;
+    if (!proxy_config.getValue(KEY_FSTYPE, fstype) || fstype != "btrfs")
+	return "";
+
+    string subvolume;
+    if (!proxy_config.getValue(KEY_SUBVOLUME, subvolume))
+	return "";
+
+    return (subvolume == "/" ? "" : subvolume) + "/" SNAPSHOTS_NAME;
+}
+
+#endif
+
+
 bool
 cleanup(ProxySnappers* snappers)
 {
@@ -118,6 +184,38 @@ cleanup(ProxySnappers* snappers)
     bool ok = true;
 
     map<string, ProxyConfig> configs = snappers->getConfigs();
+
+#ifdef ENABLE_BTRFS
+
+    // Several configs can be on the same btrfs filesystem, identified by
+    // the fsid. For those the cleanup based on free space is done once for
+    // all configs and the stale qgroups are only cleared once.
+
+    map<string, Uuid> fsids;
+    map<Uuid, vector<string>> filesystems;
+
+    for (const map<string, ProxyConfig>::value_type& value : configs)
+    {
+	string general_dir = general_dir_of(value.second);
+	if (general_dir.empty())
+	    continue;
+
+	try
+	{
+	    Uuid fsid = BtrfsUtils::get_uuid(general_dir);
+	    fsids.emplace(value.first, fsid);
+	    filesystems[fsid].push_back(value.first);
+	}
+	catch (const runtime_error& e)
+	{
+	    cerr << "querying filesystem of '" << general_dir << "' failed." << endl;
+	}
+    }
+
+    map<Uuid, vector<pair<ProxySnapper*, string>>> free_space_cleanups;
+
+#endif
+
     for (const map<string, ProxyConfig>::value_type& value : configs)
     {
 	const ProxyConfig& proxy_config = value.second;
@@ -140,69 +238,103 @@ cleanup(ProxySnappers* snappers)
 	    continue;
 	}
 
+	CleanupOptions options;
+
+#ifdef ENABLE_BTRFS
+	vector<pair<ProxySnapper*, string>>* free_space_cleanup = nullptr;
+
+	map<string, Uuid>::const_iterator fsid = fsids.find(value.first);
+	if (fsid != fsids.end() && filesystems[fsid->second].size() > 1)
+	{
+	    options.free_condition = false;
+	    free_space_cleanup = &free_space_cleanups[fsid->second];
+	}
+#endif
+
 	if (do_number)
 	{
 	    cout << "Running number cleanup for '" << value.first << "'." << endl;
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_number(snapper, verbose, report); }))
+	    if (!call_with_error_check([snapper, &options](){ do_cleanup_number(snapper, verbose, options, report); }))
 	    {
 		cerr << "number cleanup for '" << value.first << "' failed." << endl;
 		ok = false;
 	    }
+
+#ifdef ENABLE_BTRFS
+	    if (free_space_cleanup)
+		free_space_cleanup->emplace_back(snapper, "number");
+#endif
 	}
 
 	if (do_timeline)
 	{
 	    cout << "Running timeline cleanup for '" << value.first << "'." << endl;
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_timeline(snapper, verbose, report); }))
+	    if (!call_with_error_check([snapper, &options](){ do_cleanup_timeline(snapper, verbose, options, report); }))
 	    {
 		cerr << "timeline cleanup for '" << value.first << "' failed." << endl;
 		ok = false;
 	    }
+
+#ifdef ENABLE_BTRFS
+	    if (free_space_cleanup)
+		free_space_cleanup->emplace_back(snapper, "timeline");
+#endif
 	}
 
 	if (do_empty_pre_post)
 	{
 	    cout << "Running empty-pre-post cleanup for '" << value.first << "'." << endl;
 
-	    if (!call_with_error_check([snapper](){ do_cleanup_empty_pre_post(snapper, verbose, report); }))
+	    if (!call_with_error_check([snapper, &options](){ do_cleanup_empty_pre_post(snapper, verbose, options, report); }))
 	    {
 		cerr << "empty-pre-post cleanup for " << value.first << " failed." << endl;
 		ok = false;
 	    }
+
+#ifdef ENABLE_BTRFS
+	    if (free_space_cleanup)
+		free_space_cleanup->emplace_back(snapper, "empty-pre-post");
+#endif
+	}
+    }
+
+#ifdef ENABLE_BTRFS
+
+    for (const map<Uuid, vector<pair<ProxySnapper*, string>>>::value_type& value : free_space_cleanups)
+    {
+	const vector<string>& config_names = filesystems[value.first];
+
+	cout << "Running free space cleanup for '" << boost::join(config_names, "', '") << "'." << endl;
+
+	if (!call_with_error_check([&value](){ do_cleanup_free_space(value.second, verbose, report); }))
+	{
+	    cerr << "free space cleanup for '" << boost::join(config_names, "', '") << "' failed." << endl;
+	    ok = false;
 	}
+    }
 
-	string fstype;
-	if (proxy_config.getValue(KEY_FSTYPE, fstype) && fstype == "btrfs")
+#ifdef ENABLE_BTRFS_QUOTA
+    for (const map<Uuid, vector<string>>::value_type& value : filesystems)
+    {
+	// Only for filesystems with a config that has a cleanup enabled.
+
+	for (const string& config_name : value.second)
 	{
-	    string subvolume;
-	    if (proxy_config.getValue(KEY_SUBVOLUME, subvolume))
+	    const ProxyConfig& proxy_config = configs.at(config_name);
+
+	    if (proxy_config.is_yes("NUMBER_CLEANUP") || proxy_config.is_yes("TIMELINE_CLEANUP") ||
+		proxy_config.is_yes("EMPTY_PRE_POST_CLEANUP"))
 	    {
-		string general_dir = (subvolume == "/" ? "" : subvolume) + "/" SNAPSHOTS_NAME;
-
-		// Workaround for missing 'btrfs quota
-		// status'. /sys/fs/btrfs/<fsid>/qgroups is not available on all
-		// maintained kernels (only since 5.9).
-
-		SystemCmd cmd1({ BTRFS_BIN, "qgroup", "show", general_dir });
-		if (cmd1.retcode() == 0)
-		{
-		    cout << "Running 'btrfs qgroup clear-stale " << general_dir << "'." << endl;
-
-		    SystemCmd cmd2({ BTRFS_BIN, "qgroup", "clear-stale", general_dir });
-		    if (cmd2.retcode() != 0)
-		    {
-			// This fails more often than not since qgroups of just deleted
-			// subvolume are busy. So do not set an error code here. Still log the
-			// failure to help people understand this stuff.
-
-			cerr << "'btrfs qgroup clear-stale " << general_dir << "' failed." << endl;
-		    }
-		}
+		clear_stale_qgroups(general_dir_of(proxy_config));
+		break;
 	    }
 	}
     }
+#endif
+
+#endif
 
     return ok;
 }
@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread.hpp>
+
+#include <snapper/AppUtil.h>
+#include <snapper/Exception.h>
+#include <snapper/LoggerImpl.h>
+#include <snapper/Sha256.h>
+
+#include "StreamCopy.h"
+
+
+extern char** environ;
+
+
+namespace snapper
+{
+
+    using namespace std;
+
+
+    namespace
+    {
+
+	// The default pipe size of 64 KiB is increased since the stream is
+	// moved in chunks of up to the pipe size.
+
+	const int pipe_size = 1024 * 1024;
+
+
+	void
+	make_pipe(int fds[2])
+	{
+	    if (pipe2(fds, O_CLOEXEC) != 0)
+		SN_THROW(Exception(sformat("pipe2 failed errno:%d (%s)", errno,
+					   stringerror(errno).c_str())));
+
+	    if (fcntl(fds[1], F_SETPIPE_SZ, pipe_size) < 0)
+		y2war("F_SETPIPE_SZ failed errno:" << errno << " (" << stringerror(errno) << ")");
+	}
+
+
+	int
+	make_output_file(const char* name)
+	{
+	    int fd = memfd_create(name, MFD_CLOEXEC);
+	    if (fd < 0)
+		SN_THROW(Exception(sformat("memfd_create failed errno:%d (%s)", errno,
+					   stringerror(errno).c_str())));
+
+	    return fd;
+	}
+
+
+	vector<string>
+	read_output_file(int fd)
+	{
+	    string content;
+
+	    if (lseek(fd, 0, SEEK_SET) == 0)
+	    {
+		char buffer[4096];
+		ssize_t r;
+		while ((r = read(fd, buffer, sizeof(buffer))) > 0)
+		    content.append(buffer, r);
+	    }
+
+	    vector<string> lines;
+	    boost::split(lines, content, boost::is_any_of("\n"));
+
+	    if (!lines.empty() && lines.back().empty())
+		lines.pop_back();
+
+	    return lines;
+	}
+
+
+	// Same environment as used by SystemCmd.
+
+	vector<string>
+	make_env()
+	{
+	    vector<string> ret;
+
+	    for (char** v = environ; *v != NULL; ++v)
+	    {
+		if (strncmp(*v, "LC_ALL=", strlen("LC_ALL=")) != 0 &&
+		    strncmp(*v, "LANGUAGE=", strlen("LANGUAGE=")) != 0)
+		    ret.push_back(*v);
+	    }
+
+	    ret.push_back("LC_ALL=C");
+	    ret.push_back("LANGUAGE=C");
+
+	    return ret;
+	}
+
+
+	vector<char*>
+	make_pointers(const vector<string>& values)
+	{
+	    vector<char*> ret;
+
+	    for (const string& value : values)
+		ret.push_back(const_cast<char*>(value.c_str()));
+
+	    ret.push_back(nullptr);
+
+	    return ret;
+	}
+
+
+	pid_t
+	spawn(const SystemCmd::Args& args, int stdin_fd, int stdout_fd, int stderr_fd)
+	{
+	    y2mil("spawn " << boost::join(args.get_values(), " "));
+
+	    const vector<string> env = make_env();
+
+	    const vector<char*> args_p = make_pointers(args.get_values());
+	    const vector<char*> env_p = make_pointers(env);
+
+	    const int max_fd = getdtablesize();
+
+	    pid_t pid = fork();
+
+	    if (pid == 0)
+	    {
+		// Do not use exit() here. Use _exit() instead.
+
+		// Only use async‐signal‐safe functions here, see fork(2) and
+		// signal-safety(7).
+
+		sigset_t empty_set;
+		sigemptyset(&empty_set);
+		sigprocmask(SIG_SETMASK, &empty_set, nullptr);
+
+		if (dup2(stdin_fd, STDIN_FILENO) < 0)
+		    _exit(125);
+		if (dup2(stdout_fd, STDOUT_FILENO) < 0)
+		    _exit(125);
+		if (dup2(stderr_fd, STDERR_FILENO) < 0)
+		    _exit(125);
+
+		for (int fd = 3; fd < max_fd; ++fd)
+		    close(fd);
+
+		execvpe(args_p[0], args_p.data(), env_p.data());
+
+		if (errno == ENOENT)
+		    _exit(127);
+		if (errno == ENOEXEC || errno == EACCES || errno == EISDIR)
+		    _exit(126);
+		_exit(125);
+	    }
+
+	    if (pid < 0)
+		SN_THROW(Exception(sformat("fork failed errno:%d (%s)", errno,
+					   stringerror(errno).c_str())));
+
+	    return pid;
+	}
+
+
+	int
+	wait_for(pid_t pid)
+	{
+	    int status;
+
+	    while (waitpid(pid, &status, 0) < 0)
+	    {
+		if (errno != EINTR)
+		{
+		    y2err("waitpid failed errno:" << errno << " (" << stringerror(errno) << ")");
+		    return -127;
+		}
+	    }
+
+	    return WIFEXITED(status) ? WEXITSTATUS(status) : -127;
+	}
+
+
+	bool
+	wait_for(int fd, short events, int timeout)
+	{
+	    struct pollfd pfd = { fd, events, 0 };
+
+	    return poll(&pfd, 1, timeout) > 0;
+	}
+
+    }
+
+
+    StreamCopy::StreamCopy(const SystemCmd::Args& source_args,
+			   const SystemCmd::Args& destination_args)
+	: source(source_args), destination(destination_args)
+    {
+	if (source_args.get_values().empty() || destination_args.get_values().empty())
+	    SN_THROW(Exception("args empty"));
+    }
+
+
+    void
+    StreamCopy::set_skip(unsigned long long bytes, const string& digest)
+    {
+	skip_bytes = bytes;
+	skip_digest = digest;
+    }
+
+
+    void
+    StreamCopy::set_progress_callback(ProgressCallback progress_callback, unsigned int interval)
+    {
+	StreamCopy::progress_callback = progress_callback;
+	progress_interval = interval;
+    }
+
+
+    string
+    StreamCopy::cmd() const
+    {
+	string ret = boost::join(source.args.get_values(), " ") + " | ";
+
+	if (filter)
+	    ret += boost::join(filter->args.get_values(), " ") + " | ";
+
+	return ret + boost::join(destination.args.get_values(), " ");
+    }
+
+
+    void
+    StreamCopy::run()
+    {
+	y2mil("stream copy " << cmd());
+
+	int source_pipe[2];
+	make_pipe(source_pipe);
+	FdCloser source_pipe_0(source_pipe[0]);
+	FdCloser source_pipe_1(source_pipe[1]);
+
+	int destination_pipe[2];
+	make_pipe(destination_pipe);
+	FdCloser destination_pipe_0(destination_pipe[0]);
+	FdCloser destination_pipe_1(destination_pipe[1]);
+
+	int filter_in_pipe[2] = { -1, -1 };
+	int filter_out_pipe[2] = { -1, -1 };
+	if (filter)
+	{
+	    make_pipe(filter_in_pipe);
+	    make_pipe(filter_out_pipe);
+	}
+	FdCloser filter_in_pipe_0(filter_in_pipe[0]);
+	FdCloser filter_in_pipe_1(filter_in_pipe[1]);
+	FdCloser filter_out_pipe_0(filter_out_pipe[0]);
+	FdCloser filter_out_pipe_1(filter_out_pipe[1]);
+
+	int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (null_fd < 0)
+	    SN_THROW(Exception(sformat("open failed errno:%d (%s)", errno,
+				       stringerror(errno).c_str())));
+	FdCloser null_fd_closer(null_fd);
+
+	int source_output = make_output_file("source-output");
+	FdCloser source_output_closer(source_output);
+
+	int destination_output = make_output_file("destination-output");
+	FdCloser destination_output_closer(destination_output);
+
+	int filter_output = filter ? make_output_file("filter-output") : -1;
+	FdCloser filter_output_closer(filter_output);
+
+	try
+	{
+	    destination.pid = spawn(destination.args, destination_pipe[0], destination_output,
+				    destination_output);
+
+	    if (filter)
+		filter->pid = spawn(filter->args, filter_in_pipe[0], filter_out_pipe[1],
+				    filter_output);
+
+	    source.pid = spawn(source.args, null_fd, source_pipe[1], source_output);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    // Closing the pipes terminates the commands already started.
+
+	    destination_pipe_1.close();
+	    filter_in_pipe_1.close();
+	    filter_out_pipe_0.close();
+
+	    wait();
+
+	    SN_RETHROW(e);
+	}
+
+	source_pipe_1.close();
+	destination_pipe_0.close();
+	filter_in_pipe_0.close();
+	filter_out_pipe_1.close();
+
+	start = chrono::steady_clock::now();
+
+	// Each pipe is closed as soon as the copy from it finished. Closing the
+	// pipes terminates the commands if they did not finish already, e.g. if
+	// the copy failed.
+
+	bool ok = true;
+
+	if (filter)
+	{
+	    bool source_ok = true;
+
+	    boost::thread thread([&]() {
+		if (skip(source_pipe[0]))
+		    source_ok = copy(source_pipe[0], filter_in_pipe[1], source_bytes, false);
+		source_pipe_0.close();
+		filter_in_pipe_1.close();
+	    });
+
+	    ok = copy(filter_out_pipe[0], destination_pipe[1], destination_bytes, true);
+	    filter_out_pipe_0.close();
+	    destination_pipe_1.close();
+
+	    thread.join();
+
+	    ok = ok && source_ok;
+	}
+	else
+	{
+	    if (skip(source_pipe[0]))
+		ok = copy(source_pipe[0], destination_pipe[1], destination_bytes, true);
+	    source_pipe_0.close();
+	    destination_pipe_1.close();
+	}
+
+	progress = current_progress();
+
+	wait();
+
+	source.output = read_output_file(source_output);
+	destination.output = read_output_file(destination_output);
+	if (filter)
+	    filter->output = read_output_file(filter_output);
+
+	y2mil("stream copy copied " << progress.bytes << " bytes (" << progress.destination_bytes <<
+	      " bytes to destination) in " << progress.seconds << " seconds, retcodes " <<
+	      source.retcode << " " << get_filter_retcode() << " " << destination.retcode);
+
+	if (!ok)
+	    SN_THROW(Exception("stream copy failed"));
+    }
+
+
+    void
+    StreamCopy::wait()
+    {
+	if (source.pid > 0)
+	    source.retcode = wait_for(source.pid);
+
+	if (filter && filter->pid > 0)
+	    filter->retcode = wait_for(filter->pid);
+
+	if (destination.pid > 0)
+	    destination.retcode = wait_for(destination.pid);
+    }
+
+
+    bool
+    StreamCopy::skip(int in_fd)
+    {
+	if (skip_bytes == 0)
+	    return true;
+
+	Sha256 sha256;
+
+	char buffer[64 * 1024];
+
+	for (unsigned long long left = skip_bytes; left > 0; )
+	{
+	    ssize_t r = read(in_fd, buffer, min<unsigned long long>(sizeof(buffer), left));
+	    if (r < 0 && errno == EINTR)
+		continue;
+
+	    if (r <= 0)
+	    {
+		y2war("stream ended while skipping");
+		skip_matched = false;
+		return false;
+	    }
+
+	    sha256.update(buffer, r);
+	    left -= r;
+	}
+
+	skip_matched = sha256.hex_digest() == skip_digest;
+	if (!skip_matched)
+	    y2war("digest of skipped bytes does not match");
+
+	return skip_matched;
+    }
+
+
+    StreamCopy::Progress
+    StreamCopy::current_progress() const
+    {
+	Progress ret;
+
+	ret.destination_bytes = destination_bytes;
+	ret.bytes = filter ? source_bytes.load() : ret.destination_bytes;
+	ret.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	return ret;
+    }
+
+
+    bool
+    StreamCopy::copy(int in_fd, int out_fd, std::atomic<unsigned long long>& bytes, bool main)
+    {
+	// Writing to the pipe after the reader exited must not kill
+	// snapper. SIGPIPE is blocked for this thread and discarded
+	// afterwards.
+
+	sigset_t sigpipe_set;
+	sigemptyset(&sigpipe_set);
+	sigaddset(&sigpipe_set, SIGPIPE);
+
+	sigset_t old_set;
+	pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set);
+
+	// Only the copy to the destination is limited and reports the
+	// progress.
+
+	const unsigned long long limit = main ? rate_limit : 0;
+
+	size_t chunk_size = max(fcntl(out_fd, F_GETPIPE_SZ), 4096);
+	if (limit != 0)
+	    chunk_size = clamp<size_t>(limit / 10, 4096, chunk_size);
+
+	double last_report = 0.0;
+
+	bool ok = true;
+
+	while (true)
+	{
+	    if (main && progress_callback)
+	    {
+		Progress tmp = current_progress();
+		if (tmp.seconds - last_report >= progress_interval)
+		{
+		    progress_callback(tmp);
+		    last_report = tmp.seconds;
+		}
+	    }
+
+	    if (limit != 0)
+	    {
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		double ahead = (double)(bytes) / limit - seconds;
+		if (ahead > 0.0)
+		{
+		    this_thread::sleep_for(chrono::duration<double>(min(ahead, 0.5)));
+		    continue;
+		}
+	    }
+
+	    if (!wait_for(in_fd, POLLIN, 1000) || !wait_for(out_fd, POLLOUT, 1000))
+		continue;
+
+	    ssize_t r = splice(in_fd, nullptr, out_fd, nullptr, chunk_size,
+			       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+	    if (r == 0)
+		break;
+
+	    if (r < 0)
+	    {
+		if (errno == EINTR || errno == EAGAIN)
+		    continue;
+
+		// The reader exited. That is reported by the return code of
+		// the command.
+		if (errno == EPIPE)
+		    break;
+
+		y2err("splice failed errno:" << errno << " (" << stringerror(errno) << ")");
+		ok = false;
+		break;
+	    }
+
+	    bytes += r;
+	}
+
+	const struct timespec zero = { 0, 0 };
+	while (sigtimedwait(&sigpipe_set, nullptr, &zero) > 0)
+	    ;
+
+	pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+
+	return ok;
+    }
+
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#ifndef SNAPPER_STREAM_COPY_H
+#define SNAPPER_STREAM_COPY_H
+
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+
+#include "snapper/SystemCmd.h"
+
+
+namespace snapper
+{
+    using std::string;
+    using std::vector;
+
+
+    /**
+     * Runs two commands and copies the stdout of the first command to the
+     * stdin of the second command, like a shell pipe. Since the data
+     * passes through snapper the bytes copied can be counted and the
+     * throughput can be limited. The data is moved with splice(2) between
+     * two pipes with enlarged buffers.
+     *
+     * Optionally a filter command, e.g. for compression, is run between
+     * the source and the destination. The stream from the source to the
+     * filter is then copied by a second thread.
+     */
+    class StreamCopy
+    {
+    public:
+
+	struct Progress
+	{
+	    /**
+	     * Bytes read from the source and bytes written to the
+	     * destination. Only differ if a filter is used.
+	     */
+	    unsigned long long bytes = 0;
+	    unsigned long long destination_bytes = 0;
+
+	    double seconds = 0.0;
+
+	    /**
+	     * Average throughput of the source in bytes per second.
+	     */
+	    double rate() const { return seconds > 0.0 ? bytes / seconds : 0.0; }
+	};
+
+	using ProgressCallback = std::function<void(const Progress& progress)>;
+
+	StreamCopy(const SystemCmd::Args& source_args, const SystemCmd::Args& destination_args);
+
+	/**
+	 * Run the filter command between the source and the destination.
+	 */
+	void set_filter(const SystemCmd::Args& filter_args) { filter.emplace(filter_args); }
+
+	/**
+	 * Discard the given number of bytes at the beginning of the stream
+	 * from the source if their SHA-256 matches the given digest. Used
+	 * to continue an interrupted copy. If the digest does not match
+	 * the copy is stopped before anything is written to the
+	 * destination.
+	 */
+	void set_skip(unsigned long long bytes, const string& digest);
+
+	/**
+	 * Whether the skipped bytes matched the digest. Also true if
+	 * nothing was skipped.
+	 */
+	bool get_skip_matched() const { return skip_matched; }
+
+	/**
+	 * Limit the throughput to the destination to the given bytes per
+	 * second. 0 means no limit.
+	 */
+	void set_rate_limit(unsigned long long rate_limit) { StreamCopy::rate_limit = rate_limit; }
+
+	/**
+	 * Set a callback called regularly with the given interval in seconds
+	 * during the copy, also if no data is moved.
+	 */
+	void set_progress_callback(ProgressCallback progress_callback, unsigned int interval);
+
+	/**
+	 * Run the commands and copy the stream. Throws an Exception if the
+	 * commands cannot be run. Failure of the commands is only reported
+	 * by the return codes.
+	 */
+	void run();
+
+	int get_source_retcode() const { return source.retcode; }
+	int get_destination_retcode() const { return destination.retcode; }
+	int get_filter_retcode() const { return filter ? filter->retcode : 0; }
+
+	/**
+	 * The stderr of the source and the filter and the stdout and
+	 * stderr of the destination.
+	 */
+	const vector<string>& get_source_output() const { return source.output; }
+	const vector<string>& get_destination_output() const { return destination.output; }
+	const vector<string>& get_filter_output() const { return filter ? filter->output : empty_output; }
+
+	const Progress& get_progress() const { return progress; }
+
+	/**
+	 * Commands as a simple string (only for display and logging).
+	 */
+	string cmd() const;
+
+    private:
+
+	struct Process
+	{
+	    Process(const SystemCmd::Args& args) : args(args) {}
+
+	    const SystemCmd::Args args;
+	    pid_t pid = -1;
+	    int retcode = -1;
+	    vector<string> output;
+	};
+
+	bool skip(int in_fd);
+
+	bool copy(int in_fd, int out_fd, std::atomic<unsigned long long>& bytes, bool main);
+
+	Progress current_progress() const;
+
+	void wait();
+
+	Process source;
+	Process destination;
+	std::optional<Process> filter;
+
+	const vector<string> empty_output;
+
+	unsigned long long skip_bytes = 0;
+	string skip_digest;
+	bool skip_matched = true;
+
+	unsigned long long rate_limit = 0;
+
+	ProgressCallback progress_callback;
+	unsigned int progress_interval = 0;
+
+	std::chrono::steady_clock::time_point start;
+
+	std::atomic<unsigned long long> source_bytes = 0;
+	std::atomic<unsigned long long> destination_bytes = 0;
+
+	Progress progress;
+
+    };
+
+}
+
+
+#endif
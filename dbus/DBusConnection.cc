@@ -144,6 +144,30 @@ namespace DBus
     }
 
 
+    std::optional<Message>
+    Connection::read_message(int timeout)
+    {
+	DBusMessage* msg = pop_message();
+
+	if (!msg)
+	{
+	    {
+		boost::lock_guard<boost::mutex> lock(mutex);
+
+		if (!dbus_connection_read_write(conn, timeout))
+		    throw FatalException("disconnected from dbus");
+	    }
+
+	    msg = pop_message();
+	}
+
+	if (!msg)
+	    return std::nullopt;
+
+	return Message(msg, false);
+    }
+
+
     DBusMessage*
     Connection::pop_message()
     {
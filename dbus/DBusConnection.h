@@ -25,6 +25,7 @@
 
 
 #include <dbus/dbus.h>
+#include <optional>
 
 #include <boost/thread.hpp>
 #include <boost/noncopyable.hpp>
@@ -54,6 +55,15 @@ namespace DBus
 	void add_match(const string& rule) { add_match(rule.c_str()); }
 	void remove_match(const string& rule) { remove_match(rule.c_str()); }
 
+	/**
+	 * Return the next incoming message, e.g. a signal matching a rule
+	 * added with add_match(). Waits up to timeout milliseconds (-1 for
+	 * no timeout) if no message is queued. May return no message
+	 * before the timeout expired. Only for connections not used by a
+	 * MainLoop.
+	 */
+	std::optional<Message> read_message(int timeout);
+
 	uid_t get_unix_userid(const Message& m);
 
     protected:
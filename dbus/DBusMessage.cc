@@ -105,6 +105,7 @@ namespace DBus
     }
 
 
+    const char* TypeInfo<bool>::signature = "b";
     const char* TypeInfo<dbus_int32_t>::signature = "i";
     const char* TypeInfo<dbus_uint32_t>::signature = "u";
     const char* TypeInfo<dbus_uint64_t>::signature = "t";
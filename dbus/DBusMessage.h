@@ -173,6 +173,7 @@ namespace DBus
 
     template <typename Type> struct TypeInfo {};
 
+    template <> struct TypeInfo<bool> { static const char* signature; };
     template <> struct TypeInfo<dbus_int32_t> { static const char* signature; };
     template <> struct TypeInfo<dbus_uint32_t> { static const char* signature; };
     template <> struct TypeInfo<dbus_uint64_t> { static const char* signature; };
@@ -20,6 +20,7 @@ _snbk()
         -b --backup-config
 	--no-dbus
 	--target-mode
+	--full-probe
         --automatic
         --version
         --help
@@ -33,7 +34,8 @@ _snbk()
 	"restore"
 	"delete"
 	"transfer-and-delete"
-	"visualize")
+	"visualize"
+	"watch")
 
     local command i
     for (( i=0; i < ${#words[@]}-1; i++ )); do
@@ -74,6 +76,14 @@ _snbk()
                 COMPREPLY=( $( compgen -W '--rankdir -r' -- "$cur" ) )
                 return 0
                 ;;
+            watch)
+                COMPREPLY=( $( compgen -W '--delay' -- "$cur" ) )
+                return 0
+                ;;
+            transfer|transfer-and-delete)
+                COMPREPLY=( $( compgen -W '--jobs -j' -- "$cur" ) )
+                return 0
+                ;;
             *)
                 COMPREPLY=( $( compgen -W "$GLOBAL_SNBK_OPTIONS" -- "$cur" ) )
                 return 0
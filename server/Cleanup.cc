@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#include <algorithm>
+
+#include <snapper/LoggerImpl.h>
+#include <snapper/SnapperTmpl.h>
+#include <snapper/Comparison.h>
+#include <snapper/Range.h>
+#include <snapper/timeline.h>
+
+#include "Cleanup.h"
+
+
+namespace
+{
+
+    void
+    read(const ConfigInfo& config, const char* name, time_t& value)
+    {
+	string tmp;
+	if (config.get_value(name, tmp))
+	    tmp >> value;
+    }
+
+
+    void
+    read(const ConfigInfo& config, const char* name, Range& value)
+    {
+	string tmp;
+	if (!config.get_value(name, tmp))
+	    return;
+
+	try
+	{
+	    value.parse(tmp);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2war("failed to parse \"" << tmp << "\" for \"" << name << "\"");
+	}
+    }
+
+
+    bool
+    is_important(Snapshots::const_iterator it1)
+    {
+	map<string, string>::const_iterator it2 = it1->getUserdata().find("important");
+	return it2 != it1->getUserdata().end() && it2->second == "yes";
+    }
+
+
+    list<Snapshots::iterator>
+    number_candidates(const ConfigInfo& config, Snapshots& snapshots)
+    {
+	Range limit(50);
+	Range limit_important(10);
+
+	read(config, "NUMBER_LIMIT", limit);
+	read(config, "NUMBER_LIMIT_IMPORTANT", limit_important);
+
+	list<Snapshots::iterator> ret;
+
+	for (Snapshots::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	{
+	    if (it->getCleanup() == "number")
+		ret.push_front(it);
+	}
+
+	size_t num = 0;
+	size_t num_important = 0;
+
+	list<Snapshots::iterator>::iterator it = ret.begin();
+	while (it != ret.end())
+	{
+	    bool keep = false;
+
+	    if (num_important < limit_important.value(Range::MAX) && is_important(*it))
+	    {
+		++num_important;
+		keep = true;
+	    }
+	    if (num < limit.value(Range::MAX))
+	    {
+		++num;
+		keep = true;
+	    }
+
+	    if (keep)
+		it = ret.erase(it);
+	    else
+		++it;
+	}
+
+	ret.reverse();
+
+	return ret;
+    }
+
+
+    list<Snapshots::iterator>
+    timeline_candidates(const ConfigInfo& config, Snapshots& snapshots)
+    {
+	Range limit_hourly(10);
+	Range limit_daily(10);
+	Range limit_weekly(0);
+	Range limit_monthly(10);
+	Range limit_quarterly(0);
+	Range limit_yearly(10);
+
+	read(config, "TIMELINE_LIMIT_HOURLY", limit_hourly);
+	read(config, "TIMELINE_LIMIT_DAILY", limit_daily);
+	read(config, "TIMELINE_LIMIT_WEEKLY", limit_weekly);
+	read(config, "TIMELINE_LIMIT_MONTHLY", limit_monthly);
+	read(config, "TIMELINE_LIMIT_QUARTERLY", limit_quarterly);
+	read(config, "TIMELINE_LIMIT_YEARLY", limit_yearly);
+
+	list<Snapshots::iterator> ret;
+
+	for (Snapshots::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+	{
+	    if (it->getCleanup() == "timeline")
+		ret.push_front(it);
+	}
+
+	vector<TimelineEntry> entries;
+	entries.reserve(ret.size());
+
+	for (const Snapshots::iterator& it : ret)
+	{
+	    TimelineEntry entry;
+	    entry.date = it->getDate();
+	    localtime_r(&entry.date, &entry.tm);
+	    entries.push_back(entry);
+	}
+
+	TimelineLimits limits;
+	limits.hourly = limit_hourly.value(Range::MAX);
+	limits.daily = limit_daily.value(Range::MAX);
+	limits.weekly = limit_weekly.value(Range::MAX);
+	limits.monthly = limit_monthly.value(Range::MAX);
+	limits.quarterly = limit_quarterly.value(Range::MAX);
+	limits.yearly = limit_yearly.value(Range::MAX);
+
+	vector<bool> keep = timeline_keep(entries, limits);
+
+	size_t i = 0;
+	for (list<Snapshots::iterator>::iterator it = ret.begin(); it != ret.end(); ++i)
+	{
+	    if (keep[i])
+		it = ret.erase(it);
+	    else
+		++it;
+	}
+
+	ret.reverse();
+
+	return ret;
+    }
+
+
+    list<Snapshots::iterator>
+    empty_pre_post_candidates(const Snapper* snapper, Snapshots& snapshots)
+    {
+	list<Snapshots::iterator> ret;
+
+	for (Snapshots::iterator it1 = snapshots.begin(); it1 != snapshots.end(); ++it1)
+	{
+	    if (it1->getType() == PRE)
+	    {
+		Snapshots::iterator it2 = snapshots.findPost(it1);
+		if (it2 != snapshots.end() && Comparison::isEmpty(snapper, it1, it2))
+		{
+		    ret.push_back(it1);
+		    ret.push_back(it2);
+		}
+	    }
+	}
+
+	return ret;
+    }
+
+
+    // Removes snapshots that cannot be removed (e.g. btrfs active and default).
+    void
+    filter_undeletables(const Snapshots& snapshots, list<Snapshots::iterator>& tmp)
+    {
+	for (Snapshots::const_iterator undeletable : { snapshots.getDefault(), snapshots.getActive() })
+	{
+	    if (undeletable == snapshots.end())
+		continue;
+
+	    tmp.remove_if([undeletable](Snapshots::iterator it) {
+		return it->getNum() == undeletable->getNum();
+	    });
+	}
+    }
+
+
+    // Removes snapshots younger than min_age.
+    void
+    filter_min_age(time_t min_age, list<Snapshots::iterator>& tmp)
+    {
+	time_t t = time(nullptr) - min_age;
+
+	tmp.remove_if([t](Snapshots::iterator it) { return it->getDate() > t; });
+    }
+
+
+    // Removes pre and post snapshots that do have a corresponding snapshot
+    // which is not included.
+    void
+    filter_pre_post(Snapshots& snapshots, list<Snapshots::iterator>& tmp)
+    {
+	list<Snapshots::iterator> ret;
+
+	for (Snapshots::iterator it1 : tmp)
+	{
+	    Snapshots::iterator it2 = snapshots.end();
+
+	    if (it1->getType() == PRE)
+		it2 = snapshots.findPost(it1);
+	    else if (it1->getType() == POST)
+		it2 = snapshots.findPre(it1);
+
+	    if (it2 != snapshots.end() && find(tmp.begin(), tmp.end(), it2) == tmp.end())
+		continue;
+
+	    ret.push_back(it1);
+	}
+
+	swap(ret, tmp);
+    }
+
+}
+
+
+vector<Snapshots::iterator>
+cleanup_candidates(Snapper* snapper, const string& cleanup_algorithm)
+{
+    const ConfigInfo& config = snapper->getConfigInfo();
+    Snapshots& snapshots = snapper->getSnapshots();
+
+    time_t min_age = 3600;
+
+    list<Snapshots::iterator> candidates;
+
+    if (cleanup_algorithm == "number")
+    {
+	read(config, "NUMBER_MIN_AGE", min_age);
+	candidates = number_candidates(config, snapshots);
+    }
+    else if (cleanup_algorithm == "timeline")
+    {
+	read(config, "TIMELINE_MIN_AGE", min_age);
+	candidates = timeline_candidates(config, snapshots);
+    }
+    else if (cleanup_algorithm == "empty-pre-post")
+    {
+	read(config, "EMPTY_PRE_POST_MIN_AGE", min_age);
+	candidates = empty_pre_post_candidates(snapper, snapshots);
+    }
+    else
+    {
+	SN_THROW(Exception("unknown cleanup algorithm"));
+    }
+
+    filter_undeletables(snapshots, candidates);
+    filter_min_age(min_age, candidates);
+    filter_pre_post(snapshots, candidates);
+
+    return vector<Snapshots::iterator>(candidates.begin(), candidates.end());
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#ifndef SNAPPER_CLEANUP_H
+#define SNAPPER_CLEANUP_H
+
+
+#include <snapper/Snapper.h>
+
+
+using namespace snapper;
+
+
+/**
+ * Calculates the snapshots the cleanup algorithm ("number", "timeline" or
+ * "empty-pre-post") deletes based only on the limits defined in the config,
+ * without any condition. The cleanups with conditions, e.g. for quota or free
+ * space, are done by the client since they wait for quota rescans and the
+ * filesystem.
+ */
+vector<Snapshots::iterator>
+cleanup_candidates(Snapper* snapper, const string& cleanup_algorithm);
+
+
+#endif
@@ -35,6 +35,7 @@
 #include "Client.h"
 #include "MetaSnapper.h"
 #include "Background.h"
+#include "Cleanup.h"
 
 
 boost::shared_mutex big_mutex;
@@ -279,6 +280,14 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='number' type='u' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='CreateSingleSnapshots'>\n"
+	"      <arg name='config-names' type='as' direction='in'/>\n"
+	"      <arg name='description' type='s' direction='in'/>\n"
+	"      <arg name='cleanup' type='s' direction='in'/>\n"
+	"      <arg name='userdata' type='a{ss}' direction='in'/>\n"
+	"      <arg name='numbers' type='au' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='CreateSingleSnapshotV2'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='parent-number' type='u' direction='in'/>\n"
@@ -354,6 +363,12 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='sued-space' type='u' direction='out'/>\n"
 	"    </method>\n"
 
+	"    <method name='GetUsedSpaces'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='numbers' type='au' direction='in'/>\n"
+	"      <arg name='used-spaces' type='at' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='MountSnapshot'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='number' type='u' direction='in'/>\n"
@@ -386,6 +401,13 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='number2' type='u' direction='in'/>\n"
 	"    </method>\n"
 
+	"    <method name='IsComparisonEmpty'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='numbers1' type='au' direction='in'/>\n"
+	"      <arg name='numbers2' type='au' direction='in'/>\n"
+	"      <arg name='empty' type='ab' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='GetFiles'>\n"
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"      <arg name='number1' type='u' direction='in'/>\n"
@@ -404,6 +426,13 @@ Client::introspect(DBus::Connection& conn, DBus::Message& msg)
 	"      <arg name='config-name' type='s' direction='in'/>\n"
 	"    </method>\n"
 
+	"    <method name='Cleanup'>\n"
+	"      <arg name='config-name' type='s' direction='in'/>\n"
+	"      <arg name='cleanup-algorithm' type='s' direction='in'/>\n"
+	"      <arg name='options' type='a{ss}' direction='in'/>\n"
+	"      <arg name='numbers' type='au' direction='out'/>\n"
+	"    </method>\n"
+
 	"    <method name='GetPluginsReport'>\n"
 	"      <arg name='report' type='a(sasi)' direction='out'/>\n"
 	"    </method>\n"
@@ -948,6 +977,73 @@ Client::create_single_snapshot(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::create_single_snapshots(DBus::Connection& conn, DBus::Message& msg)
+{
+    vector<string> config_names;
+    SCD scd;
+
+    DBus::Unmarshaller unmarshaller(msg);
+    unmarshaller >> config_names >> scd.description >> scd.cleanup >> scd.userdata;
+
+    y2deb("CreateSingleSnapshots config_names:" << config_names << " description:" << scd.description <<
+	  " cleanup:" << scd.cleanup);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    // A config that cannot be used must not prevent the snapshots of the
+    // other configs. A number of 0 indicates that creating the snapshot
+    // failed.
+
+    vector<dbus_uint32_t> nums(config_names.size(), 0);
+
+    vector<size_t> indices;
+    vector<Snapper*> snappers;
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	try
+	{
+	    MetaSnappers::iterator it = meta_snappers.find(config_names[i]);
+
+	    check_permission(conn, msg, *it);
+
+	    snappers.push_back(it->getSnapper());
+	    indices.push_back(i);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    y2err("creating snapshot for '" << config_names[i] << "' failed, " << e.what());
+	}
+    }
+
+    scd.uid = uid;
+
+    vector<Snapshots::iterator> snaps = Snapper::createSingleSnapshots(snappers, scd, report);
+
+    for (size_t i = 0; i < snappers.size(); ++i)
+    {
+	if (snaps[i] != snappers[i]->getSnapshots().end())
+	    nums[indices[i]] = snaps[i]->getNum();
+    }
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Marshaller marshaller(reply);
+    marshaller << nums;
+
+    conn.send(reply);
+
+    for (size_t i = 0; i < config_names.size(); ++i)
+    {
+	if (nums[i] != 0)
+	    signal_snapshot_created(conn, config_names[i], nums[i]);
+    }
+}
+
+
 void
 Client::create_single_snapshot_v2(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1124,15 +1220,17 @@ Client::delete_snapshots(DBus::Connection& conn, DBus::Message& msg)
     Snapper* snapper = it1->getSnapper();
     Snapshots& snapshots = snapper->getSnapshots();
 
+    vector<Snapshots::iterator> snaps;
+
     for (vector<unsigned int>::const_iterator it2 = nums.begin(); it2 != nums.end(); ++it2)
     {
 	check_snapshot_in_use(*it1, *it2);
 
-	Snapshots::iterator snap = snapshots.find(*it2);
-
-	snapper->deleteSnapshot(snap, report);
+	snaps.push_back(snapshots.find(*it2));
     }
 
+    snapper->deleteSnapshots(snaps, report);
+
     DBus::MessageMethodReturn reply(msg);
 
     conn.send(reply);
@@ -1344,6 +1442,49 @@ Client::get_used_space(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::get_used_spaces(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+    vector<dbus_uint32_t> nums;
+
+    DBus::Unmarshaller unmarshaller(msg);
+    unmarshaller >> config_name >> nums;
+
+    y2deb("GetUsedSpaces config_name:" << config_name << " nums:" << nums);
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    Snapper* snapper = it->getSnapper();
+    Snapshots& snapshots = snapper->getSnapshots();
+
+    // The used spaces of all snapshots are read at once and cached, see
+    // Btrfs::queryQGroupUsage().
+
+    vector<dbus_uint64_t> used_spaces;
+
+    for (dbus_uint32_t num : nums)
+    {
+	Snapshots::iterator snap = snapshots.find(num);
+	if (snap == snapshots.end())
+	    SN_THROW(IllegalSnapshotException());
+
+	used_spaces.push_back(snap->getUsedSpace());
+    }
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Marshaller marshaller(reply);
+    marshaller << used_spaces;
+
+    conn.send(reply);
+}
+
+
 void
 Client::mount_snapshot(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1501,6 +1642,50 @@ Client::create_comparison(DBus::Connection& conn, DBus::Message& msg)
 }
 
 
+void
+Client::is_comparison_empty(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+    vector<dbus_uint32_t> nums1, nums2;
+
+    DBus::Unmarshaller unmarshaller(msg);
+    unmarshaller >> config_name >> nums1 >> nums2;
+
+    y2deb("IsComparisonEmpty config_name:" << config_name << " nums1:" << nums1 << " nums2:" << nums2);
+
+    if (nums1.size() != nums2.size())
+	SN_THROW(IllegalSnapshotException());
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+
+    Snapper* snapper = it->getSnapper();
+    Snapshots& snapshots = snapper->getSnapshots();
+
+    vector<pair<Snapshots::const_iterator, Snapshots::const_iterator>> pairs;
+    for (size_t i = 0; i < nums1.size(); ++i)
+	pairs.emplace_back(snapshots.find(nums1[i]), snapshots.find(nums2[i]));
+
+    RefHolder ref_holder(*it);
+
+    lock.unlock();
+
+    vector<bool> empty;
+    for (const pair<Snapshots::const_iterator, Snapshots::const_iterator>& tmp : pairs)
+	empty.push_back(Comparison::isEmpty(snapper, tmp.first, tmp.second));
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Marshaller marshaller(reply);
+    marshaller << empty;
+
+    conn.send(reply);
+}
+
+
 void
 Client::delete_comparison(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1730,14 +1915,110 @@ Client::sync(DBus::Connection& conn, DBus::Message& msg)
 
     Snapper* snapper = it->getSnapper();
 
+    RefHolder ref_holder(*it);
+
+    lock.unlock();
+
     snapper->syncFilesystem();
 
+    lock.lock();
+
     DBus::MessageMethodReturn reply(msg);
 
     conn.send(reply);
 }
 
 
+void
+Client::cleanup(DBus::Connection& conn, DBus::Message& msg)
+{
+    string config_name;
+    string cleanup_algorithm;
+    map<string, string> options;
+
+    DBus::Unmarshaller unmarshaller(msg);
+    unmarshaller >> config_name >> cleanup_algorithm >> options;
+
+    y2deb("Cleanup config_name:" << config_name << " cleanup_algorithm:" << cleanup_algorithm);
+
+    if (!options.empty())
+	SN_THROW(InvalidCleanupArguments());
+
+    static const vector<string> cleanup_algorithms = { "number", "timeline", "empty-pre-post" };
+
+    if (find(cleanup_algorithms.begin(), cleanup_algorithms.end(), cleanup_algorithm) ==
+	cleanup_algorithms.end())
+	SN_THROW(InvalidCleanupArguments());
+
+    // Only the cleanup based on the limits is done here. It does not wait
+    // for quota rescans or the filesystem so the big lock can be held
+    // during the complete cleanup and no other client can modify the
+    // snapshots meanwhile.
+
+    boost::unique_lock<boost::shared_mutex> lock(big_mutex);
+
+    MetaSnappers::iterator it = meta_snappers.find(config_name);
+
+    check_permission(conn, msg, *it);
+    check_lock(conn, msg, config_name);
+
+    Snapper* snapper = it->getSnapper();
+    const Snapshots& snapshots = snapper->getSnapshots();
+
+    // Snapshots mounted by any client are not deleted, as with
+    // DeleteSnapshots.
+
+    vector<Snapshots::iterator> candidates = cleanup_candidates(snapper, cleanup_algorithm);
+
+    vector<unsigned int> old_nums;
+    for (Snapshots::iterator candidate : candidates)
+    {
+	check_snapshot_in_use(*it, candidate->getNum());
+	old_nums.push_back(candidate->getNum());
+    }
+
+    std::function<vector<dbus_uint32_t>()> deleted_nums = [&old_nums, &snapshots]() {
+	vector<dbus_uint32_t> ret;
+	for (unsigned int num : old_nums)
+	    if (snapshots.find(num) == snapshots.end())
+		ret.push_back(num);
+	return ret;
+    };
+
+    if (!candidates.empty())
+    {
+	try
+	{
+	    snapper->deleteSnapshots(candidates, report);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    // Some snapshots might have been deleted before the error.
+
+	    vector<dbus_uint32_t> nums = deleted_nums();
+	    if (!nums.empty())
+		signal_snapshots_deleted(conn, config_name, nums);
+
+	    SN_RETHROW(e);
+	}
+    }
+
+    vector<dbus_uint32_t> nums = deleted_nums();
+
+    DBus::MessageMethodReturn reply(msg);
+
+    DBus::Marshaller marshaller(reply);
+    marshaller << nums;
+
+    conn.send(reply);
+
+    if (!nums.empty())
+	signal_snapshots_deleted(conn, config_name, nums);
+}
+
+
 void
 Client::get_plugins_report(DBus::Connection& conn, DBus::Message& msg)
 {
@@ -1869,6 +2150,7 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	{ "GetSnapshot", &Client::get_snapshot },
 	{ "SetSnapshot", &Client::set_snapshot },
 	{ "CreateSingleSnapshot", &Client::create_single_snapshot },
+	{ "CreateSingleSnapshots", &Client::create_single_snapshots },
 	{ "CreateSingleSnapshotV2", &Client::create_single_snapshot_v2 },
 	{ "CreateSingleSnapshotOfDefault", &Client::create_single_snapshot_of_default },
 	{ "CreatePreSnapshot", &Client::create_pre_snapshot },
@@ -1880,11 +2162,13 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	{ "GetActiveSnapshot", &Client::get_active_snapshot },
 	{ "CalculateUsedSpace", &Client::calculate_used_space },
 	{ "GetUsedSpace", &Client::get_used_space },
+	{ "GetUsedSpaces", &Client::get_used_spaces },
 	{ "MountSnapshot", &Client::mount_snapshot },
 	{ "UmountSnapshot", &Client::umount_snapshot },
 	{ "GetMountPoint", &Client::get_mount_point },
 	{ "CreateComparison", &Client::create_comparison },
 	{ "DeleteComparison", &Client::delete_comparison },
+	{ "IsComparisonEmpty", &Client::is_comparison_empty },
 	{ "GetFiles", &Client::get_files },
 	{ "GetFilesByPipe", &Client::get_files_by_pipe },
 	{ "SetupQuota", &Client::setup_quota },
@@ -1892,6 +2176,7 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	{ "QueryQuota", &Client::query_quota },
 	{ "QueryFreeSpace", &Client::query_free_space },
 	{ "Sync", &Client::sync },
+	{ "Cleanup", &Client::cleanup },
 	{ "GetPluginsReport", &Client::get_plugins_report },
 	{ "ClearPluginsReport", &Client::clear_plugins_report },
 	{ "Debug", &Client::debug }
@@ -1976,6 +2261,12 @@ Client::dispatch(DBus::Connection& conn, DBus::Message& msg)
 	DBus::MessageError reply(msg, "error.snapshot_in_use", DBUS_ERROR_FAILED);
 	conn.send(reply);
     }
+    catch (const InvalidCleanupArguments& e)
+    {
+	SN_CAUGHT(e);
+	DBus::MessageError reply(msg, "error.invalid_cleanup_arguments", DBUS_ERROR_FAILED);
+	conn.send(reply);
+    }
     catch (const NoComparison& e)
     {
 	SN_CAUGHT(e);
@@ -63,6 +63,12 @@ struct NoComparison : Exception
 };
 
 
+struct InvalidCleanupArguments : Exception
+{
+    explicit InvalidCleanupArguments() : Exception("invalid cleanup arguments") {}
+};
+
+
 class Client : private boost::noncopyable
 {
 public:
@@ -98,6 +104,7 @@ public:
     void get_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void set_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot(DBus::Connection& conn, DBus::Message& msg);
+    void create_single_snapshots(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot_v2(DBus::Connection& conn, DBus::Message& msg);
     void create_single_snapshot_of_default(DBus::Connection& conn, DBus::Message& msg);
     void create_pre_snapshot(DBus::Connection& conn, DBus::Message& msg);
@@ -109,11 +116,13 @@ public:
     void get_active_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void calculate_used_space(DBus::Connection& conn, DBus::Message& msg);
     void get_used_space(DBus::Connection& conn, DBus::Message& msg);
+    void get_used_spaces(DBus::Connection& conn, DBus::Message& msg);
     void mount_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void umount_snapshot(DBus::Connection& conn, DBus::Message& msg);
     void get_mount_point(DBus::Connection& conn, DBus::Message& msg);
     void create_comparison(DBus::Connection& conn, DBus::Message& msg);
     void delete_comparison(DBus::Connection& conn, DBus::Message& msg);
+    void is_comparison_empty(DBus::Connection& conn, DBus::Message& msg);
     void get_files(DBus::Connection& conn, DBus::Message& msg);
     void get_files_by_pipe(DBus::Connection& conn, DBus::Message& msg);
     void setup_quota(DBus::Connection& conn, DBus::Message& msg);
@@ -121,6 +130,7 @@ public:
     void query_quota(DBus::Connection& conn, DBus::Message& msg);
     void query_free_space(DBus::Connection& conn, DBus::Message& msg);
     void sync(DBus::Connection& conn, DBus::Message& msg);
+    void cleanup(DBus::Connection& conn, DBus::Message& msg);
     void get_plugins_report(DBus::Connection& conn, DBus::Message& msg);
     void clear_plugins_report(DBus::Connection& conn, DBus::Message& msg);
     void debug(DBus::Connection& conn, DBus::Message& msg);
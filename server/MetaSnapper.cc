@@ -122,6 +122,18 @@ MetaSnapper::getSnapper()
 void
 MetaSnapper::unload()
 {
+    if (snapper)
+    {
+	try
+	{
+	    snapper->removeOrphanedInfoDirs();
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+	}
+    }
+
     snapper.reset();
 }
 
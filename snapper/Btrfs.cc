@@ -44,6 +44,7 @@
 #include <boost/thread.hpp>
 #endif
 #include <regex>
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 
 #include "snapper/LoggerImpl.h"
@@ -342,6 +343,8 @@ namespace snapper
 		y2err("create snapshot failed, " << e.what());
 		SN_THROW(CreateSnapshotFailedException());
 	    }
+
+	    invalidateQGroupUsage();
 	}
 	else
 	{
@@ -358,6 +361,8 @@ namespace snapper
 		y2err("create snapshot failed, " << e.what());
 		SN_THROW(CreateSnapshotFailedException());
 	    }
+
+	    invalidateQGroupUsage();
 	}
     }
 
@@ -396,6 +401,8 @@ namespace snapper
 	    y2err("create snapshot failed, " << e.what());
 	    SN_THROW(CreateSnapshotFailedException());
 	}
+
+	invalidateQGroupUsage();
     }
 
 #else
@@ -422,6 +429,8 @@ namespace snapper
 
 	    delete_subvolume(info_dir.fd(), SNAPSHOT_NAME);
 
+	    invalidateQGroupUsage();
+
 #if defined(HAVE_LIBBTRFS) || defined(HAVE_LIBBTRFSUTIL)
 	    deleted_subvolids.push_back(subvolid);
 #endif
@@ -526,10 +535,18 @@ namespace snapper
 	void dump(const string& prefix = "") const;
 
 	unsigned int check(StreamProcessor* processor, const string& name, unsigned int status) const;
+
 	void check(StreamProcessor* processor, const string& prefix = "");
 
 	void result(cmpdirs_cb_t cb, const string& prefix = "") const;
 
+	/**
+	 * Check the status of all nodes and report the changed ones. The
+	 * callback is called directly after a node is checked so that the
+	 * callback can stop the expensive checks by throwing.
+	 */
+	void check_and_report(StreamProcessor* processor, cmpdirs_cb_t cb, const string& prefix = "");
+
     };
 
 
@@ -673,7 +690,7 @@ namespace snapper
 	const SDir& dir1;
 	const SDir& dir2;
 
-	void process(cmpdirs_cb_t cb);
+	void process(cmpdirs_cb_t cb, bool early);
 
 	tree_node files;
 
@@ -722,16 +739,10 @@ namespace snapper
     {
 	for (iterator it = children.begin(); it != children.end(); ++it)
 	{
-	    if (prefix.empty())
-	    {
-		it->second.status = check(processor, it->first, it->second.status);
-		it->second.check(processor, it->first);
-	    }
-	    else
-	    {
-		it->second.status = check(processor, prefix + "/" + it->first, it->second.status);
-		it->second.check(processor, prefix + "/" + it->first);
-	    }
+	    string name = prefix.empty() ? it->first : prefix + "/" + it->first;
+
+	    it->second.status = check(processor, name, it->second.status);
+	    it->second.check(processor, name);
 	}
     }
 
@@ -741,18 +752,27 @@ namespace snapper
     {
 	for (const_iterator it = children.begin(); it != children.end(); ++it)
 	{
-	    if (prefix.empty())
-	    {
-		if (it->second.status != 0)
-		    (cb)("/" + it->first, it->second.status);
-		it->second.result(cb, it->first);
-	    }
-	    else
-	    {
-		if (it->second.status != 0)
-		    (cb)("/" + prefix + "/" + it->first, it->second.status);
-		it->second.result(cb, prefix + "/" + it->first);
-	    }
+	    string name = prefix.empty() ? it->first : prefix + "/" + it->first;
+
+	    if (it->second.status != 0)
+		(cb)("/" + name, it->second.status);
+	    it->second.result(cb, name);
+	}
+    }
+
+
+    void
+    tree_node::check_and_report(StreamProcessor* processor, cmpdirs_cb_t cb, const string& prefix)
+    {
+	for (iterator it = children.begin(); it != children.end(); ++it)
+	{
+	    string name = prefix.empty() ? it->first : prefix + "/" + it->first;
+
+	    it->second.status = check(processor, name, it->second.status);
+	    if (it->second.status != 0)
+		(cb)("/" + name, it->second.status);
+
+	    it->second.check_and_report(processor, cb, name);
 	}
     }
 
@@ -1334,7 +1354,7 @@ namespace snapper
 
 
     void
-    StreamProcessor::process(cmpdirs_cb_t cb)
+    StreamProcessor::process(cmpdirs_cb_t cb, bool early)
     {
 	y2mil("dir1:'" << dir1.fullname() << "' dir2:'" << dir2.fullname() << "'");
 
@@ -1357,13 +1377,20 @@ namespace snapper
 
 	do_send(parent_root_id, clone_sources);
 
-	files.check(&*this);
-	files.result(cb);
+	if (early)
+	{
+	    files.check_and_report(&*this, cb);
+	}
+	else
+	{
+	    files.check(&*this);
+	    files.result(cb);
+	}
     }
 
 
     void
-    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb, bool early) const
     {
 	if (special_cmp)
 	{
@@ -1377,7 +1404,7 @@ namespace snapper
 
 		StreamProcessor processor(subvolume, dir1, dir2);
 
-		processor.process(cb);
+		processor.process(cb, early);
 
 		y2mil("stopwatch " << stopwatch << " for comparing directories");
 	    }
@@ -1402,7 +1429,7 @@ namespace snapper
 
 
     void
-    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Btrfs::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb, bool early) const
     {
 	snapper::cmpDirs(dir1, dir2, cb);
     }
@@ -1584,6 +1611,106 @@ namespace snapper
 #endif
 
 
+    QGroupUsage
+    Btrfs::queryQGroupUsage(qgroup_t qgroup) const
+    {
+#ifdef ENABLE_BTRFS_QUOTA
+
+	SDir general_dir = openGeneralDir();
+
+	boost::lock_guard<boost::mutex> lock(qgroup_usage_mutex);
+
+	updateQGroupUsage(general_dir.fd());
+
+	map<qgroup_t, QGroupUsage>::const_iterator it = qgroup_usage_cache.qgroup_usages.find(qgroup);
+	if (it == qgroup_usage_cache.qgroup_usages.end())
+	    throw std::runtime_error("qgroup info not found");
+
+	return it->second;
+
+#else
+
+	SN_THROW(QuotaException("not implemented"));
+	__builtin_unreachable();
+
+#endif
+    }
+
+
+    bool
+    Btrfs::isQGroupUsageRescanned() const
+    {
+#ifdef ENABLE_BTRFS_QUOTA
+
+	SDir general_dir = openGeneralDir();
+
+	boost::lock_guard<boost::mutex> lock(qgroup_usage_mutex);
+
+	if (!qgroup_usage_cache.rescanned)
+	    return false;
+
+	updateQGroupUsage(general_dir.fd());
+
+	return qgroup_usage_cache.rescanned;
+
+#else
+
+	return false;
+
+#endif
+    }
+
+
+    void
+    Btrfs::setQGroupUsageRescanned() const
+    {
+#ifdef ENABLE_BTRFS_QUOTA
+
+	SDir general_dir = openGeneralDir();
+
+	boost::lock_guard<boost::mutex> lock(qgroup_usage_mutex);
+
+	qgroup_usage_cache = QGroupUsageCache();
+
+	updateQGroupUsage(general_dir.fd());
+
+	qgroup_usage_cache.rescanned = true;
+
+#endif
+    }
+
+
+    void
+    Btrfs::invalidateQGroupUsage() const
+    {
+	boost::lock_guard<boost::mutex> lock(qgroup_usage_mutex);
+
+	qgroup_usage_cache = QGroupUsageCache();
+    }
+
+
+    void
+    Btrfs::updateQGroupUsage(int fd) const
+    {
+#ifdef ENABLE_BTRFS_QUOTA
+
+	// The generation is read before the usage so that a concurrent
+	// update is detected on the next call.
+
+	uint64_t generation = qgroup_query_generation(fd);
+
+	if (qgroup_usage_cache.valid && qgroup_usage_cache.generation == generation)
+	    return;
+
+	qgroup_usage_cache.qgroup_usages = qgroup_query_usages(fd);
+	qgroup_usage_cache.generation = generation;
+	qgroup_usage_cache.valid = true;
+	qgroup_usage_cache.rescanned = false;
+
+#endif
+    }
+
+
     void
     Btrfs::sync() const
     {
@@ -1594,10 +1721,24 @@ namespace snapper
 	if (!deleted_subvolids.empty())
 	{
 #ifdef HAVE_LIBBTRFS
-	    for (subvolid_t subvolid : deleted_subvolids)
+	    // Wait for the cleaner to remove all deleted subvolumes. All
+	    // remaining subvolumes are checked in each round and the delay
+	    // between the rounds grows from 10 ms to 1 s.
+
+	    useconds_t delay = 10000;
+
+	    while (true)
 	    {
-		while (does_subvolume_exist(subvolume_dir.fd(), subvolid))
-		    sleep(1);
+		deleted_subvolids.erase(remove_if(deleted_subvolids.begin(), deleted_subvolids.end(),
+						  [&subvolume_dir](subvolid_t subvolid) {
+						      return !does_subvolume_exist(subvolume_dir.fd(), subvolid);
+						  }), deleted_subvolids.end());
+
+		if (deleted_subvolids.empty())
+		    break;
+
+		usleep(delay);
+		delay = min(2 * delay, (useconds_t) 1000000);
 	    }
 #endif
 
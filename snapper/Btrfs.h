@@ -25,6 +25,8 @@
 #define SNAPPER_BTRFS_H
 
 
+#include <boost/thread/mutex.hpp>
+
 #include "snapper/Filesystem.h"
 #include "snapper/BtrfsUtils.h"
 
@@ -81,7 +83,8 @@ namespace snapper
 
 	virtual bool checkSnapshot(unsigned int num) const override;
 
-	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const override;
+	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+			     bool early = false) const override;
 
 	virtual bool isDefault(unsigned int num) const override;
 
@@ -97,6 +100,23 @@ namespace snapper
 
 	virtual qgroup_t getQGroup() const { return qgroup; }
 
+	/**
+	 * Query the usage of the qgroup. The usage of all qgroups is read
+	 * at once and cached until the qgroup generation changes or
+	 * snapshots are created or deleted.
+	 */
+	QGroupUsage queryQGroupUsage(qgroup_t qgroup) const;
+
+	/**
+	 * Whether the qgroup usage was read since the last quota rescan and
+	 * is still valid. In that case another rescan is not needed.
+	 */
+	bool isQGroupUsageRescanned() const;
+
+	void setQGroupUsageRescanned() const;
+
+	void invalidateQGroupUsage() const;
+
     private:
 
 	qgroup_t qgroup = no_qgroup;
@@ -104,6 +124,23 @@ namespace snapper
 
 	mutable vector<subvolid_t> deleted_subvolids;
 
+	struct QGroupUsageCache
+	{
+	    bool valid = false;
+	    bool rescanned = false;
+	    uint64_t generation = 0;
+	    map<qgroup_t, QGroupUsage> qgroup_usages;
+	};
+
+	mutable boost::mutex qgroup_usage_mutex;
+	mutable QGroupUsageCache qgroup_usage_cache;
+
+	/**
+	 * Refreshes the cache if it is invalid or outdated. The mutex must
+	 * be locked.
+	 */
+	void updateQGroupUsage(int fd) const;
+
 	void addToFstabHelper(const string& default_subvolume_name) const;
 	void removeFromFstabHelper() const;
 
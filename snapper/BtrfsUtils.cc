@@ -42,6 +42,7 @@
 #endif
 #include <algorithm>
 #include <functional>
+#include <sstream>
 
 #include "snapper/LoggerImpl.h"
 #include "snapper/AppUtil.h"
@@ -431,6 +432,159 @@ namespace snapper
 #endif
 	}
 
+
+	struct TreeSearchOpts
+	{
+	    TreeSearchOpts(__u32 type) : min_type(type), max_type(type) {}
+
+	    __u64 tree_id = BTRFS_QUOTA_TREE_OBJECTID;
+
+	    __u64 min_offset = 0;
+	    __u64 max_offset = -1;
+
+	    __u32 min_type;
+	    __u32 max_type;
+
+	    std::function<void(const struct btrfs_ioctl_search_args& args,
+			       const struct btrfs_ioctl_search_header& sh)> callback =
+		[](const struct btrfs_ioctl_search_args& args,
+		   const struct btrfs_ioctl_search_header& sh){};
+	};
+
+
+	/*
+	 * Wrapper for ioctl(BTRFS_IOC_TREE_SEARCH). Calls callback of
+	 * tree_search_opts for every found item.  In contrast to the bare
+	 * ioctl the wrapper ensures that the min and max values in
+	 * tree_search_opts are satisfied.  Returns the number of times the
+	 * callback was called.
+	 */
+	size_t
+	tree_search(int fd, const TreeSearchOpts& tree_search_opts)
+	{
+	    struct btrfs_ioctl_search_args args;
+	    memset(&args, 0, sizeof(args));
+
+	    struct btrfs_ioctl_search_key* sk = &args.key;
+	    sk->tree_id = tree_search_opts.tree_id;
+	    sk->min_objectid = 0;
+	    sk->max_objectid = BTRFS_LAST_FREE_OBJECTID;
+	    sk->min_offset = tree_search_opts.min_offset;
+	    sk->max_offset = tree_search_opts.max_offset;
+	    sk->min_transid = 0;
+	    sk->max_transid = (u64)(-1);
+	    sk->min_type = tree_search_opts.min_type;
+	    sk->max_type = tree_search_opts.max_type;
+	    sk->nr_items = 4096;
+
+	    size_t n = 0;
+
+	    while (true)
+	    {
+		if (ioctl(fd, BTRFS_IOC_TREE_SEARCH, &args) < 0)
+		    throw runtime_error_with_errno("ioctl(BTRFS_IOC_TREE_SEARCH) failed", errno);
+
+		if (sk->nr_items == 0)
+		    break;
+
+		u64 off = 0;
+
+		for (unsigned int i = 0; i < sk->nr_items; ++i)
+		{
+		    struct btrfs_ioctl_search_header* sh = (struct btrfs_ioctl_search_header*)(args.buf + off);
+
+		    if (sh->offset >= tree_search_opts.min_offset && sh->offset <= tree_search_opts.max_offset &&
+			sh->type >= tree_search_opts.min_type && sh->type <= tree_search_opts.max_type)
+		    {
+			tree_search_opts.callback(args, *sh);
+			++n;
+		    }
+
+		    off += sizeof(*sh) + sh->len;
+
+		    sk->min_type = sh->type;
+		    sk->min_objectid = sh->objectid;
+		    sk->min_offset = sh->offset;
+		}
+
+		sk->nr_items = 4096;
+
+		if (sk->min_offset < (u64)(-1))
+		    sk->min_offset++;
+		else
+		    break;
+	    }
+
+	    return n;
+	}
+
+
+	namespace
+	{
+
+	    string
+	    format_uuid(const __u8 value[BTRFS_UUID_SIZE])
+	    {
+		static_assert(BTRFS_UUID_SIZE == 16, "unexpected value of BTRFS_UUID_SIZE");
+
+		if (std::all_of(value, value + BTRFS_UUID_SIZE, [](__u8 c) { return c == 0; }))
+		    return "";
+
+		Uuid uuid;
+		std::copy(value, value + BTRFS_UUID_SIZE, std::begin(uuid.value));
+
+		std::ostringstream s;
+		s << uuid;
+		return s.str();
+	    }
+
+	}
+
+
+	map<subvolid_t, SubvolumeInfo>
+	get_subvolume_infos(int fd)
+	{
+	    map<subvolid_t, SubvolumeInfo> subvolume_infos;
+
+	    TreeSearchOpts tree_search_opts(BTRFS_ROOT_ITEM_KEY);
+	    tree_search_opts.tree_id = BTRFS_ROOT_TREE_OBJECTID;
+	    tree_search_opts.callback = [&subvolume_infos](const struct btrfs_ioctl_search_args& args,
+							   const struct btrfs_ioctl_search_header& sh)
+	    {
+		// Only the top-level subvolume and real subvolumes, not the
+		// internal trees.
+
+		if (sh.objectid != BTRFS_FS_TREE_OBJECTID && sh.objectid < BTRFS_FIRST_FREE_OBJECTID)
+		    return;
+
+		// Old root items are shorter and do not include the uuids
+		// and times. The uuids and times are only valid if
+		// generation_v2 matches generation.
+
+		struct btrfs_root_item root_item;
+		memset(&root_item, 0, sizeof(root_item));
+		memcpy(&root_item, (const char*)(&sh) + sizeof(sh), std::min((size_t) sh.len, sizeof(root_item)));
+
+		SubvolumeInfo subvolume_info;
+		subvolume_info.id = sh.objectid;
+		subvolume_info.read_only = le64_to_cpu(root_item.flags) & BTRFS_ROOT_SUBVOL_RDONLY;
+
+		if (le64_to_cpu(root_item.generation_v2) == le64_to_cpu(root_item.generation))
+		{
+		    subvolume_info.uuid = format_uuid(root_item.uuid);
+		    subvolume_info.parent_uuid = format_uuid(root_item.parent_uuid);
+		    subvolume_info.received_uuid = format_uuid(root_item.received_uuid);
+		    subvolume_info.otime = le64_to_cpu(root_item.otime.sec);
+		}
+
+		subvolume_infos[sh.objectid] = subvolume_info;
+	    };
+
+	    tree_search(fd, tree_search_opts);
+
+	    return subvolume_infos;
+	}
+
 #endif
 
 
@@ -599,90 +753,6 @@ namespace snapper
 	}
 
 
-	struct TreeSearchOpts
-	{
-	    TreeSearchOpts(__u32 type) : min_type(type), max_type(type) {}
-
-	    __u64 min_offset = 0;
-	    __u64 max_offset = -1;
-
-	    __u32 min_type;
-	    __u32 max_type;
-
-	    std::function<void(const struct btrfs_ioctl_search_args& args,
-			       const struct btrfs_ioctl_search_header& sh)> callback =
-		[](const struct btrfs_ioctl_search_args& args,
-		   const struct btrfs_ioctl_search_header& sh){};
-	};
-
-
-	/*
-	 * Wrapper for ioctl(BTRFS_IOC_TREE_SEARCH). Calls callback of
-	 * tree_search_opts for every found item.  In contrast to the bare
-	 * ioctl the wrapper ensures that the min and max values in
-	 * tree_search_opts are satisfied.  Returns the number of times the
-	 * callback was called.
-	 */
-	size_t
-	qgroups_tree_search(int fd, const TreeSearchOpts& tree_search_opts)
-	{
-	    struct btrfs_ioctl_search_args args;
-	    memset(&args, 0, sizeof(args));
-
-	    struct btrfs_ioctl_search_key* sk = &args.key;
-	    sk->tree_id = BTRFS_QUOTA_TREE_OBJECTID;
-	    sk->min_objectid = 0;
-	    sk->max_objectid = BTRFS_LAST_FREE_OBJECTID;
-	    sk->min_offset = tree_search_opts.min_offset;
-	    sk->max_offset = tree_search_opts.max_offset;
-	    sk->min_transid = 0;
-	    sk->max_transid = (u64)(-1);
-	    sk->min_type = tree_search_opts.min_type;
-	    sk->max_type = tree_search_opts.max_type;
-	    sk->nr_items = 4096;
-
-	    size_t n = 0;
-
-	    while (true)
-	    {
-		if (ioctl(fd, BTRFS_IOC_TREE_SEARCH, &args) < 0)
-		    throw runtime_error_with_errno("ioctl(BTRFS_IOC_TREE_SEARCH) failed", errno);
-
-		if (sk->nr_items == 0)
-		    break;
-
-		u64 off = 0;
-
-		for (unsigned int i = 0; i < sk->nr_items; ++i)
-		{
-		    struct btrfs_ioctl_search_header* sh = (struct btrfs_ioctl_search_header*)(args.buf + off);
-
-		    if (sh->offset >= tree_search_opts.min_offset && sh->offset <= tree_search_opts.max_offset &&
-			sh->type >= tree_search_opts.min_type && sh->type <= tree_search_opts.max_type)
-		    {
-			tree_search_opts.callback(args, *sh);
-			++n;
-		    }
-
-		    off += sizeof(*sh) + sh->len;
-
-		    sk->min_type = sh->type;
-		    sk->min_objectid = sh->objectid;
-		    sk->min_offset = sh->offset;
-		}
-
-		sk->nr_items = 4096;
-
-		if (sk->min_offset < (u64)(-1))
-		    sk->min_offset++;
-		else
-		    break;
-	    }
-
-	    return n;
-	}
-
-
 	bool
 	does_qgroup_exist(int fd, qgroup_t qgroup)
 	{
@@ -691,7 +761,7 @@ namespace snapper
 
 	    try
 	    {
-		return qgroups_tree_search(fd, tree_search_opts) > 0;
+		return tree_search(fd, tree_search_opts) > 0;
 	    }
 	    catch (const std::runtime_error& e)
 	    {
@@ -715,7 +785,7 @@ namespace snapper
 		qgroups.push_back(sh.offset);
 	    };
 
-	    qgroups_tree_search(fd, tree_search_opts);
+	    tree_search(fd, tree_search_opts);
 
 	    if (qgroups.empty() || get_id(qgroups.front()) != 0)
 		return calc_qgroup(level, 0);
@@ -745,7 +815,7 @@ namespace snapper
 		ret.push_back(sh.objectid);
 	    };
 
-	    qgroups_tree_search(fd, tree_search_opts);
+	    tree_search(fd, tree_search_opts);
 
 	    return ret;
 	}
@@ -789,7 +859,7 @@ namespace snapper
 		qgroup_usage.exclusive_compressed = le64_to_cpu(info.exclusive_compressed);
 	    };
 
-	    int n = qgroups_tree_search(fd, tree_search_opts);
+	    int n = tree_search(fd, tree_search_opts);
 
 	    if (n == 0)
 		throw std::runtime_error("qgroup info not found");
@@ -799,6 +869,139 @@ namespace snapper
 	    return qgroup_usage;
 	}
 
+
+	map<qgroup_t, QGroupUsage>
+	qgroup_query_usages(int fd)
+	{
+	    map<qgroup_t, QGroupUsage> qgroup_usages;
+
+	    TreeSearchOpts tree_search_opts(BTRFS_QGROUP_INFO_KEY);
+	    tree_search_opts.callback = [&qgroup_usages](const struct btrfs_ioctl_search_args& args,
+							 const struct btrfs_ioctl_search_header& sh)
+	    {
+		struct btrfs_qgroup_info_item info;
+		memcpy(&info, (const char*)(&sh) + sizeof(sh), sizeof(info));
+
+		QGroupUsage& qgroup_usage = qgroup_usages[sh.offset];
+		qgroup_usage.referenced = le64_to_cpu(info.referenced);
+		qgroup_usage.referenced_compressed = le64_to_cpu(info.referenced_compressed);
+		qgroup_usage.exclusive = le64_to_cpu(info.exclusive);
+		qgroup_usage.exclusive_compressed = le64_to_cpu(info.exclusive_compressed);
+	    };
+
+	    tree_search(fd, tree_search_opts);
+
+	    return qgroup_usages;
+	}
+
+
+	uint64_t
+	qgroup_query_generation(int fd)
+	{
+	    uint64_t generation = 0;
+
+	    TreeSearchOpts tree_search_opts(BTRFS_QGROUP_STATUS_KEY);
+	    tree_search_opts.callback = [&generation](const struct btrfs_ioctl_search_args& args,
+						      const struct btrfs_ioctl_search_header& sh)
+	    {
+		struct btrfs_qgroup_status_item status;
+		memcpy(&status, (const char*)(&sh) + sizeof(sh), sizeof(status));
+
+		generation = le64_to_cpu(status.generation);
+	    };
+
+	    if (tree_search(fd, tree_search_opts) != 1)
+		throw std::runtime_error("qgroup status not found");
+
+	    return generation;
+	}
+
+
+	bool
+	is_quota_enabled(int fd)
+	{
+	    bool enabled = false;
+
+	    TreeSearchOpts tree_search_opts(BTRFS_QGROUP_STATUS_KEY);
+	    tree_search_opts.callback = [&enabled](const struct btrfs_ioctl_search_args& args,
+						   const struct btrfs_ioctl_search_header& sh)
+	    {
+		struct btrfs_qgroup_status_item status;
+		memcpy(&status, (const char*)(&sh) + sizeof(sh), sizeof(status));
+
+		enabled = le64_to_cpu(status.flags) & BTRFS_QGROUP_STATUS_FLAG_ON;
+	    };
+
+	    try
+	    {
+		tree_search(fd, tree_search_opts);
+	    }
+	    catch (const std::runtime_error& e)
+	    {
+		// happens when quota is disabled since then the quota tree
+		// does not exist
+		return false;
+	    }
+
+	    return enabled;
+	}
+
+
+	vector<qgroup_t>
+	qgroup_find_stale(int fd)
+	{
+	    // All subvolumes have a root item in the root tree.
+
+	    vector<subvolid_t> subvolids;
+
+	    TreeSearchOpts tree_search_opts(BTRFS_ROOT_ITEM_KEY);
+	    tree_search_opts.tree_id = BTRFS_ROOT_TREE_OBJECTID;
+	    tree_search_opts.callback = [&subvolids](const struct btrfs_ioctl_search_args& args,
+						     const struct btrfs_ioctl_search_header& sh)
+	    {
+		subvolids.push_back(sh.objectid);
+	    };
+
+	    tree_search(fd, tree_search_opts);
+
+	    sort(subvolids.begin(), subvolids.end());
+
+	    vector<qgroup_t> stale;
+
+	    for (const map<qgroup_t, QGroupUsage>::value_type& value : qgroup_query_usages(fd))
+	    {
+		if (get_level(value.first) != 0)
+		    continue;
+
+		if (!binary_search(subvolids.begin(), subvolids.end(), get_id(value.first)))
+		    stale.push_back(value.first);
+	    }
+
+	    return stale;
+	}
+
+
+	unsigned int
+	qgroup_clear_stale(int fd)
+	{
+	    unsigned int failed = 0;
+
+	    for (qgroup_t qgroup : qgroup_find_stale(fd))
+	    {
+		try
+		{
+		    qgroup_destroy(fd, qgroup);
+		}
+		catch (const std::runtime_error& e)
+		{
+		    y2war("destroying qgroup " << format_qgroup(qgroup) << " failed, " << e.what());
+		    ++failed;
+		}
+	    }
+
+	    return failed;
+	}
+
 #endif
 
 
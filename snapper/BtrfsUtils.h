@@ -26,8 +26,10 @@
 
 
 #include <cstdint>
+#include <ctime>
 #include <string>
 #include <vector>
+#include <map>
 
 #include "snapper/AppUtil.h"
 
@@ -36,6 +38,7 @@ namespace snapper
 {
     using std::string;
     using std::vector;
+    using std::map;
 
 
     namespace BtrfsUtils
@@ -64,6 +67,22 @@ namespace snapper
 	string get_subvolume(int fd, subvolid_t id);
 	subvolid_t get_id(int fd);
 
+	struct SubvolumeInfo
+	{
+	    subvolid_t id = 0;
+	    string uuid;
+	    string parent_uuid;
+	    string received_uuid;
+	    time_t otime = 0;
+	    bool read_only = false;
+	};
+
+	/**
+	 * Query information about all subvolumes with a single tree
+	 * search. Uuids that are not set are empty.
+	 */
+	map<subvolid_t, SubvolumeInfo> get_subvolume_infos(int fd);
+
 	void quota_enable(int fd);
 	void quota_disable(int fd);
 
@@ -97,6 +116,34 @@ namespace snapper
 
 	QGroupUsage qgroup_query_usage(int fd, qgroup_t qgroup);
 
+	/**
+	 * Query the usage of all qgroups with a single tree search.
+	 */
+	map<qgroup_t, QGroupUsage> qgroup_query_usages(int fd);
+
+	/**
+	 * Query the generation of the qgroup status item. The generation
+	 * changes whenever a transaction updates the qgroup accounting.
+	 */
+	uint64_t qgroup_query_generation(int fd);
+
+	/**
+	 * Check whether quota is enabled on the filesystem.
+	 */
+	bool is_quota_enabled(int fd);
+
+	/**
+	 * Find the level-0 qgroups of subvolumes that do no longer exist.
+	 */
+	vector<qgroup_t> qgroup_find_stale(int fd);
+
+	/**
+	 * Destroy the stale level-0 qgroups, like 'btrfs qgroup
+	 * clear-stale'. Returns the number of qgroups that could not be
+	 * destroyed, usually since they are still busy.
+	 */
+	unsigned int qgroup_clear_stale(int fd);
+
 	void sync(int fd);
 
 	Uuid get_uuid(int fd);
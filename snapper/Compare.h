@@ -38,6 +38,13 @@ namespace snapper
     typedef std::function<void(const string& name, unsigned int status)> cmpdirs_cb_t;
 
 
+    /* Can be thrown by a cmpdirs_cb_t to stop comparing the directories,
+       e.g. if only the existence of a difference is of interest.
+       Intentionally not derived from Exception so that it is not
+       handled like an error. */
+    struct CmpDirsStop {};
+
+
     /* Compares the two files. */
     unsigned int
     cmpFiles(const SFile& file1, const SFile& file2);
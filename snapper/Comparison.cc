@@ -51,6 +51,27 @@ namespace snapper
 			   Snapshots::const_iterator snapshot2, bool mount)
 	: snapper(snapper), snapshot1(snapshot1), snapshot2(snapshot2), mount(mount),
 	  files(&file_paths)
+    {
+	setup();
+
+	initialize();
+
+	if (mount)
+	    do_mount();
+    }
+
+
+    Comparison::Comparison(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+			   Snapshots::const_iterator snapshot2)
+	: snapper(snapper), snapshot1(snapshot1), snapshot2(snapshot2), mount(false),
+	  files(&file_paths)
+    {
+	setup();
+    }
+
+
+    void
+    Comparison::setup()
     {
 	if (snapshot1 == snapper->getSnapshots().end() ||
 	    snapshot2 == snapper->getSnapshots().end() ||
@@ -62,11 +83,6 @@ namespace snapper
 	file_paths.system_path = snapper->subvolumeDir();
 	file_paths.pre_path = snapshot1->snapshotDir();
 	file_paths.post_path = snapshot2->snapshotDir();
-
-	initialize();
-
-	if (mount)
-	    do_mount();
     }
 
 
@@ -77,28 +93,31 @@ namespace snapper
     }
 
 
-    void
-    Comparison::initialize()
+    bool
+    Comparison::is_fixed() const
     {
 	// When booting a snapshot the current snapshot could be read-only.
 	// But which snapshot is booted as current snapshot might not be constant.
 
-	bool fixed = !getSnapshot1()->isCurrent() && !getSnapshot2()->isCurrent();
+	if (getSnapshot1()->isCurrent() || getSnapshot2()->isCurrent())
+	    return false;
 
-	if (fixed)
+	try
 	{
-	    try
-	    {
-		fixed = getSnapshot1()->isReadOnly() && getSnapshot2()->isReadOnly();
-	    }
-	    catch (const runtime_error& e)
-	    {
-		y2err("failed to query read-only status, " << e.what());
-		fixed = false;
-	    }
+	    return getSnapshot1()->isReadOnly() && getSnapshot2()->isReadOnly();
 	}
+	catch (const runtime_error& e)
+	{
+	    y2err("failed to query read-only status, " << e.what());
+	    return false;
+	}
+    }
 
-	if (!fixed)
+
+    void
+    Comparison::initialize()
+    {
+	if (!is_fixed())
 	{
 	    create();
 	}
@@ -162,6 +181,56 @@ namespace snapper
     }
 
 
+    bool
+    Comparison::isEmpty(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+			Snapshots::const_iterator snapshot2)
+    {
+	Comparison comparison(snapper, snapshot1, snapshot2);
+
+	const vector<string>& ignore_patterns = snapper->getIgnorePatterns();
+
+	if (comparison.is_fixed() && comparison.load())
+	{
+	    comparison.filter();
+
+	    return comparison.files.empty();
+	}
+
+	bool empty = true;
+
+	cmpdirs_cb_t cb = [&ignore_patterns, &empty](const string& name, unsigned int status) {
+	    if (is_ignored(name, ignore_patterns))
+		return;
+
+	    empty = false;
+	    throw CmpDirsStop();
+	};
+
+	comparison.do_mount();
+
+	try
+	{
+	    SDir dir1 = snapshot1->openSnapshotDir();
+	    SDir dir2 = snapshot2->openSnapshotDir();
+	    snapper->getFilesystem()->cmpDirs(dir1, dir2, cb, true);
+	}
+	catch (const CmpDirsStop&)
+	{
+	}
+	catch (...)
+	{
+	    comparison.do_umount();
+	    throw;
+	}
+
+	comparison.do_umount();
+
+	y2mil("num1:" << snapshot1->getNum() << " num2:" << snapshot2->getNum() << " empty:" << empty);
+
+	return empty;
+    }
+
+
     bool
     Comparison::check_header(const string& line) const
     {
@@ -48,6 +48,15 @@ namespace snapper
 
 	~Comparison();
 
+	/**
+	 * Check whether the comparison of the two snapshots is empty after
+	 * applying the ignore patterns. A saved filelist is used if
+	 * available, otherwise comparing stops at the first difference. In
+	 * contrast to a Comparison object nothing is saved.
+	 */
+	static bool isEmpty(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+			    Snapshots::const_iterator snapshot2);
+
 	const Snapper* getSnapper() const { return snapper; }
 
 	Snapshots::const_iterator getSnapshot1() const { return snapshot1; }
@@ -65,6 +74,17 @@ namespace snapper
 
     private:
 
+	Comparison(const Snapper* snapper, Snapshots::const_iterator snapshot1,
+		   Snapshots::const_iterator snapshot2);
+
+	/**
+	 * Whether the comparison can change, e.g. if one snapshot is the
+	 * current system or not read-only. Only fixed comparisons are
+	 * saved.
+	 */
+	bool is_fixed() const;
+
+	void setup();
 	void initialize();
 	void create();
 
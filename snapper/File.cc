@@ -94,10 +94,7 @@ namespace snapper
     Files::filter(const vector<string>& ignore_patterns)
     {
 	std::function<bool(const File&)> pred = [&ignore_patterns](const File& file) {
-	    for (const string& ignore_pattern : ignore_patterns)
-		if (fnmatch(ignore_pattern.c_str(), file.getName().c_str(), FNM_LEADING_DIR) == 0)
-		    return true;
-	    return false;
+	    return is_ignored(file.getName(), ignore_patterns);
 	};
 
 	entries.erase(remove_if(entries.begin(), entries.end(), pred), entries.end());
@@ -855,4 +852,15 @@ namespace snapper
 	return status;
     }
 
+
+    bool
+    is_ignored(const string& name, const vector<string>& ignore_patterns)
+    {
+	for (const string& ignore_pattern : ignore_patterns)
+	    if (fnmatch(ignore_pattern.c_str(), name.c_str(), FNM_LEADING_DIR) == 0)
+		return true;
+
+	return false;
+    }
+
 }
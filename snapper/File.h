@@ -240,6 +240,10 @@ namespace snapper
     unsigned int
     invertStatus(unsigned int status);
 
+    /* Checks whether the name matches one of the ignore patterns. */
+    bool
+    is_ignored(const string& name, const vector<string>& ignore_patterns);
+
 }
 
 
@@ -163,7 +163,7 @@ namespace snapper
 
 
     void
-    Filesystem::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const
+    Filesystem::cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb, bool early) const
     {
 	snapper::cmpDirs(dir1, dir2, cb);
     }
@@ -92,7 +92,15 @@ namespace snapper
 
 	virtual bool checkSnapshot(unsigned int num) const = 0;
 
-	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb) const;
+	/**
+	 * Compare the two directories. If early is true the callback is
+	 * called as soon as a difference is known so that it can stop the
+	 * comparison by throwing CmpDirsStop. In that mode the callback must
+	 * tolerate being called again for the same file since the comparison
+	 * may be restarted with a different method.
+	 */
+	virtual void cmpDirs(const SDir& dir1, const SDir& dir2, cmpdirs_cb_t cb,
+			     bool early = false) const;
 
 	virtual bool isDefault(unsigned int num) const;
 
@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#include "config.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <libxml/xmlreader.h>
+
+#include "snapper/InfoXml.h"
+#include "snapper/AppUtil.h"
+#include "snapper/FileUtils.h"
+#include "snapper/Sha256.h"
+#include "snapper/LoggerImpl.h"
+#include "snapper/Exception.h"
+
+
+namespace snapper
+{
+
+    namespace
+    {
+
+	class XmlReader
+	{
+	public:
+
+	    XmlReader(int fd)
+		: reader(xmlReaderForFd(fd, "", NULL, XML_PARSE_NOBLANKS | XML_PARSE_NONET))
+	    {
+		if (!reader)
+		    SN_THROW(IOErrorException("xmlReaderForFd failed"));
+	    }
+
+	    ~XmlReader()
+	    {
+		xmlFreeTextReader(reader);
+	    }
+
+	    bool read()
+	    {
+		int r = xmlTextReaderRead(reader);
+		if (r < 0)
+		    SN_THROW(IOErrorException("xmlTextReaderRead failed"));
+
+		return r == 1;
+	    }
+
+	    int depth() const { return xmlTextReaderDepth(reader); }
+
+	    int type() const { return xmlTextReaderNodeType(reader); }
+
+	    bool is_empty() const { return xmlTextReaderIsEmptyElement(reader) == 1; }
+
+	    const char* name() const { return (const char*) xmlTextReaderConstName(reader); }
+
+	    string value() const
+	    {
+		if (is_empty())
+		    return "";
+
+		xmlChar* tmp = xmlTextReaderReadString(reader);
+		if (!tmp)
+		    return "";
+
+		string ret = (const char*) tmp;
+		xmlFree(tmp);
+		return ret;
+	    }
+
+	private:
+
+	    xmlTextReader* reader;
+
+	};
+
+
+	// Same conversion as done by getChildValue() of XmlFile.
+	template<typename Type>
+	void
+	from_string(const string& str, Type& value)
+	{
+	    std::istringstream istr(str);
+	    classic(istr);
+	    istr >> value;
+	}
+
+
+	// Escapes the text like libxml2 does for a document without an
+	// encoding: '<', '>', '&' and carriage return are replaced by
+	// references and all non-ASCII characters by character references.
+	// Characters not allowed in XML 1.0 and invalid UTF-8 sequences are
+	// dropped.
+	void
+	escape(string& out, const string& in)
+	{
+	    static const char hex[] = "0123456789ABCDEF";
+
+	    for (string::size_type i = 0; i < in.size(); ++i)
+	    {
+		unsigned char c = in[i];
+
+		switch (c)
+		{
+		    case '<': out += "&lt;"; continue;
+		    case '>': out += "&gt;"; continue;
+		    case '&': out += "&amp;"; continue;
+		    case '\r': out += "&#xD;"; continue;
+		    case '\t': case '\n': out += c; continue;
+		}
+
+		if (c < 0x20)
+		    continue;
+
+		if (c < 0x80)
+		{
+		    out += c;
+		    continue;
+		}
+
+		unsigned int len = (c & 0xe0) == 0xc0 ? 2 : (c & 0xf0) == 0xe0 ? 3 : (c & 0xf8) == 0xf0 ? 4 : 0;
+		if (len == 0 || i + len > in.size())
+		    continue;
+
+		unsigned int code_point = c & (0xff >> (len + 1));
+		bool valid = true;
+
+		for (unsigned int j = 1; j < len; ++j)
+		{
+		    unsigned char d = in[i + j];
+		    if ((d & 0xc0) != 0x80)
+		    {
+			valid = false;
+			break;
+		    }
+
+		    code_point = (code_point << 6) | (d & 0x3f);
+		}
+
+		if (!valid)
+		    continue;
+
+		i += len - 1;
+
+		out += "&#x";
+
+		char buffer[8];
+		int n = 0;
+		do
+		{
+		    buffer[n++] = hex[code_point & 0xf];
+		    code_point >>= 4;
+		}
+		while (code_point != 0);
+
+		while (n > 0)
+		    out += buffer[--n];
+
+		out += ';';
+	    }
+	}
+
+
+	void
+	add_element(string& out, const char* indent, const char* name, const string& value)
+	{
+	    out += indent;
+	    out += '<';
+	    out += name;
+	    out += '>';
+	    escape(out, value);
+	    out += "</";
+	    out += name;
+	    out += ">\n";
+	}
+
+
+	template<typename Type>
+	void
+	add_element(string& out, const char* indent, const char* name, const Type& value)
+	{
+	    std::ostringstream ostr;
+	    classic(ostr);
+	    ostr << value;
+	    add_element(out, indent, name, ostr.str());
+	}
+
+
+	void
+	write_all(int fd, const string& content)
+	{
+	    for (string::size_type pos = 0; pos < content.size(); )
+	    {
+		ssize_t r = ::write(fd, content.data() + pos, content.size() - pos);
+		if (r < 0)
+		{
+		    if (errno == EINTR)
+			continue;
+
+		    SN_THROW(IOErrorException(sformat("write failed, errno:%d (%s)", errno,
+						      stringerror(errno).c_str())));
+		}
+
+		pos += r;
+	    }
+	}
+
+
+	const char* const checksum_name = "info.xml.sha256";
+
+	// Same format as the output of sha256sum.
+	const char* const checksum_suffix = "  info.xml\n";
+
+	const size_t checksum_length = 64;
+
+
+	bool
+	is_checksum(const string& checksum)
+	{
+	    return checksum.size() == checksum_length &&
+		checksum.find_first_not_of("0123456789abcdef") == string::npos;
+	}
+
+
+	bool
+	newer_or_equal(const struct timespec& a, const struct timespec& b)
+	{
+	    return a.tv_sec > b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec >= b.tv_nsec);
+	}
+
+
+	// Returns an empty string if the checksum file is missing, older than
+	// info.xml or malformed.
+	string
+	read_checksum_file(const SDir& info_dir)
+	{
+	    struct stat info_stat;
+	    if (info_dir.stat("info.xml", &info_stat, AT_SYMLINK_NOFOLLOW) != 0)
+		return "";
+
+	    int fd = info_dir.open(checksum_name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	    if (fd < 0)
+		return "";
+
+	    FdCloser fd_closer(fd);
+
+	    struct stat checksum_stat;
+	    if (fstat(fd, &checksum_stat) != 0 || !S_ISREG(checksum_stat.st_mode) ||
+		!newer_or_equal(checksum_stat.st_mtim, info_stat.st_mtim))
+		return "";
+
+	    char buffer[128];
+	    ssize_t r = read(fd, buffer, sizeof(buffer));
+	    if (r < 0)
+		return "";
+
+	    const string content(buffer, r);
+	    const string checksum = content.substr(0, checksum_length);
+
+	    if (!is_checksum(checksum) || content.compare(checksum_length, string::npos, checksum_suffix) != 0)
+		return "";
+
+	    return checksum;
+	}
+
+    }
+
+
+    void
+    InfoXml::read(int fd)
+    {
+	FdCloser fd_closer(fd);
+
+	XmlReader reader(fd);
+
+	bool has_uid = false;
+	bool has_pre_num = false;
+	bool has_description = false;
+	bool has_cleanup = false;
+
+	bool in_userdata = false;
+	bool has_key = false;
+	bool has_value = false;
+	string key;
+	string value;
+
+	// As with getChildValue() only the first occurrence of an element is
+	// used.
+
+	while (reader.read())
+	{
+	    int depth = reader.depth();
+	    int node_type = reader.type();
+
+	    if (depth == 1 && in_userdata && node_type == XML_READER_TYPE_END_ELEMENT)
+	    {
+		if (!key.empty())
+		    userdata[key] = value;
+
+		in_userdata = false;
+		continue;
+	    }
+
+	    if (node_type != XML_READER_TYPE_ELEMENT)
+		continue;
+
+	    const char* name = reader.name();
+
+	    if (depth == 1)
+	    {
+		if (strcmp(name, "type") == 0 && !has_type)
+		{
+		    type = reader.value();
+		    has_type = true;
+		}
+		else if (strcmp(name, "num") == 0 && !has_num)
+		{
+		    from_string(reader.value(), num);
+		    has_num = true;
+		}
+		else if (strcmp(name, "date") == 0 && !has_date)
+		{
+		    date = reader.value();
+		    has_date = true;
+		}
+		else if (strcmp(name, "uid") == 0 && !has_uid)
+		{
+		    from_string(reader.value(), uid);
+		    has_uid = true;
+		}
+		else if (strcmp(name, "pre_num") == 0 && !has_pre_num)
+		{
+		    from_string(reader.value(), pre_num);
+		    has_pre_num = true;
+		}
+		else if (strcmp(name, "description") == 0 && !has_description)
+		{
+		    description = reader.value();
+		    has_description = true;
+		}
+		else if (strcmp(name, "cleanup") == 0 && !has_cleanup)
+		{
+		    cleanup = reader.value();
+		    has_cleanup = true;
+		}
+		else if (strcmp(name, "userdata") == 0 && !reader.is_empty())
+		{
+		    in_userdata = true;
+		    has_key = has_value = false;
+		    key.clear();
+		    value.clear();
+		}
+	    }
+	    else if (depth == 2 && in_userdata)
+	    {
+		if (strcmp(name, "key") == 0 && !has_key)
+		{
+		    key = reader.value();
+		    has_key = true;
+		}
+		else if (strcmp(name, "value") == 0 && !has_value)
+		{
+		    value = reader.value();
+		    has_value = true;
+		}
+	    }
+	}
+    }
+
+
+    string
+    InfoXml::write() const
+    {
+	string out = "<?xml version=\"1.0\"?>\n<snapshot>\n";
+
+	add_element(out, "  ", "type", type);
+
+	add_element(out, "  ", "num", num);
+
+	add_element(out, "  ", "date", date);
+
+	if (uid != 0)
+	    add_element(out, "  ", "uid", uid);
+
+	if (pre_num != 0)
+	    add_element(out, "  ", "pre_num", pre_num);
+
+	if (!description.empty())
+	    add_element(out, "  ", "description", description);
+
+	if (!cleanup.empty())
+	    add_element(out, "  ", "cleanup", cleanup);
+
+	for (const map<string, string>::value_type& value : userdata)
+	{
+	    out += "  <userdata>\n";
+	    add_element(out, "    ", "key", value.first);
+	    add_element(out, "    ", "value", value.second);
+	    out += "  </userdata>\n";
+	}
+
+	out += "</snapshot>\n";
+
+	return out;
+    }
+
+
+    void
+    InfoXml::write(int fd) const
+    {
+	FdCloser fd_closer(fd);
+
+	write_all(fd, write());
+
+	if (fsync(fd) != 0)
+	    SN_THROW(IOErrorException(sformat("fsync failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+
+	if (fd_closer.close() != 0)
+	    SN_THROW(IOErrorException(sformat("close failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+    }
+
+
+
+    string
+    InfoXml::checksum() const
+    {
+	Sha256 sha256;
+	sha256.update(write());
+	return sha256.hex_digest();
+    }
+
+
+    void
+    write_info_xml_checksum(const SDir& info_dir, const string& checksum)
+    {
+	// The file is only an optimization and thus not synced. A file
+	// truncated by a crash is detected when reading it.
+
+	string tmp_name = string(checksum_name) + ".tmp-XXXXXX";
+
+	int fd = info_dir.mktemp(tmp_name);
+	if (fd < 0)
+	    SN_THROW(IOErrorException(sformat("SDir::mktemp failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
+
+	fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+	try
+	{
+	    FdCloser fd_closer(fd);
+
+	    write_all(fd, checksum + checksum_suffix);
+
+	    if (fd_closer.close() != 0)
+		SN_THROW(IOErrorException(sformat("close failed, errno:%d (%s)", errno,
+						  stringerror(errno).c_str())));
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    info_dir.unlink(tmp_name);
+
+	    SN_RETHROW(e);
+	}
+
+	if (info_dir.rename(tmp_name, checksum_name) != 0)
+	{
+	    int tmp_errno = errno;
+	    info_dir.unlink(tmp_name);
+
+	    SN_THROW(IOErrorException(sformat("rename %s failed, errno:%d (%s)", checksum_name, tmp_errno,
+					      stringerror(tmp_errno).c_str())));
+	}
+    }
+
+
+    void
+    remove_info_xml_checksum(const SDir& info_dir)
+    {
+	if (info_dir.unlink(checksum_name) != 0 && errno != ENOENT)
+	    SN_THROW(IOErrorException(sformat("unlink %s failed, errno:%d (%s)", checksum_name, errno,
+					      stringerror(errno).c_str())));
+    }
+
+
+    string
+    info_xml_checksum(const SDir& info_dir)
+    {
+	string checksum = read_checksum_file(info_dir);
+	if (!checksum.empty())
+	    return checksum;
+
+	y2deb("computing checksum of " << info_dir.fullname("info.xml"));
+
+	return sha256_file(info_dir.fd(), "info.xml");
+    }
+
+}
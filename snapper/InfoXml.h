@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#ifndef SNAPPER_INFO_XML_H
+#define SNAPPER_INFO_XML_H
+
+
+#include <sys/types.h>
+#include <string>
+#include <map>
+
+
+namespace snapper
+{
+    using std::string;
+    using std::map;
+
+
+    class SDir;
+
+
+    /**
+     * Reader and writer for the info.xml file of a snapshot.
+     *
+     * In contrast to XmlFile no DOM is built. The reader uses the libxml2
+     * xmlTextReader and only looks at the elements of the fixed info.xml
+     * schema, the writer directly generates the text. The output of the
+     * writer is identical to the output of XmlFile for the same content.
+     */
+    class InfoXml
+    {
+    public:
+
+	string type;
+	unsigned int num = 0;
+	string date;
+	uid_t uid = 0;
+	unsigned int pre_num = 0;
+	string description;
+	string cleanup;
+	map<string, string> userdata;
+
+	/**
+	 * Whether the mandatory elements were found by read().
+	 */
+	bool has_type = false;
+	bool has_num = false;
+	bool has_date = false;
+
+	/**
+	 * Read the info.xml from fd. The fd is closed. Throws an
+	 * IOErrorException if the file is not well-formed.
+	 */
+	void read(int fd);
+
+	/**
+	 * Return the content of the info.xml. The elements uid,
+	 * pre_num, description and cleanup are only included if they
+	 * have a non-default value.
+	 */
+	string write() const;
+
+	/**
+	 * Write the info.xml to fd and sync it. The fd is closed. Throws
+	 * an IOErrorException on failure.
+	 */
+	void write(int fd) const;
+
+	/**
+	 * Return the SHA-256 of the content written by write() as
+	 * lowercase hex string.
+	 */
+	string checksum() const;
+
+    };
+
+
+    /**
+     * Write the checksum of the info.xml in info_dir to the file
+     * info.xml.sha256 next to it. The file has the format of sha256sum.
+     * Throws an IOErrorException on failure.
+     */
+    void
+    write_info_xml_checksum(const SDir& info_dir, const string& checksum);
+
+
+    /**
+     * Remove the file info.xml.sha256 in info_dir if it exists. Must be
+     * called before the info.xml is replaced.
+     */
+    void
+    remove_info_xml_checksum(const SDir& info_dir);
+
+
+    /**
+     * Return the SHA-256 of the info.xml in info_dir. The checksum is
+     * taken from info.xml.sha256 if that file is not older than the
+     * info.xml, otherwise it is computed. Throws an IOErrorException if
+     * the info.xml cannot be read.
+     */
+    string
+    info_xml_checksum(const SDir& info_dir);
+
+}
+
+
+#endif
@@ -22,10 +22,9 @@
 
 #include <sstream>
 
-#include <snapper/Exception.h>
-#include <snapper/SnapperTmpl.h>
-
-#include "Range.h"
+#include "snapper/Exception.h"
+#include "snapper/SnapperTmpl.h"
+#include "snapper/Range.h"
 
 
 namespace snapper
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+
+#ifndef SNAPPER_SHA256_H
+#define SNAPPER_SHA256_H
+
+
+#include <stdint.h>
+#include <string>
+
+
+namespace snapper
+{
+    using std::string;
+
+
+    /**
+     * Incremental SHA-256 as specified in FIPS 180-4. Used to compute the
+     * same checksum as sha256sum without running an external program.
+     */
+    class Sha256
+    {
+    public:
+
+	Sha256();
+
+	void update(const void* data, size_t size);
+	void update(const string& data) { update(data.data(), data.size()); }
+
+	/**
+	 * Finish the computation and return the digest as lowercase hex
+	 * string. Afterwards the object must not be updated anymore.
+	 */
+	string hex_digest();
+
+    private:
+
+	void transform(const unsigned char* block);
+
+	uint32_t state[8];
+	unsigned char buffer[64];
+	size_t buffer_size = 0;
+	uint64_t total_size = 0;
+
+    };
+
+
+    /**
+     * Return the SHA-256 of the file as lowercase hex string. Throws an
+     * IOErrorException if the file cannot be read.
+     */
+    string
+    sha256_file(int dirfd, const string& name);
+
+}
+
+
+#endif
@@ -32,7 +32,9 @@
 #include <acl/libacl.h>
 #include <set>
 #include <regex>
+#include <atomic>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread.hpp>
 
 #include "snapper/Snapper.h"
 #include "snapper/Comparison.h"
@@ -63,6 +65,10 @@ namespace snapper
     using namespace std;
 
 
+    // Maximal number of threads used by createSingleSnapshots().
+    static const size_t max_create_threads = 16;
+
+
     Snapper::Snapper(const string& config_name, const string& root_prefix, bool disable_filters)
 	: config_name(config_name), root_prefix(root_prefix), snapshots(this)
     {
@@ -216,6 +222,107 @@ namespace snapper
     }
 
 
+    vector<Snapshots::iterator>
+    Snapper::createSingleSnapshots(const vector<Snapper*>& snappers, const SCD& scd, Plugins::Report& report)
+    {
+	const size_t n = snappers.size();
+
+	vector<Snapshots::iterator> ret;
+	vector<std::unique_ptr<Snapshot>> snapshots(n);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+	    Snapshots& tmp = snappers[i]->snapshots;
+
+	    ret.push_back(tmp.end());
+
+	    try
+	    {
+		snapshots[i].reset(new Snapshot(tmp.newSingleSnapshot(scd)));
+		tmp.createHelperPrepare(*snapshots[i], report);
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+
+		y2err("creating snapshot for " << snappers[i]->configName() << " failed");
+		snapshots[i].reset();
+	    }
+	}
+
+	// Creating a filesystem snapshot is a single ioctl for btrfs. Doing
+	// it concurrently for all configs lets the filesystem handle them in
+	// few transactions.
+
+	std::atomic<size_t> next(0);
+
+	std::function<void()> worker = [&snappers, &scd, &snapshots, &next, n]() {
+	    for (size_t j = next++; j < n; j = next++)
+	    {
+		if (!snapshots[j])
+		    continue;
+
+		const Snapshots& tmp = snappers[j]->snapshots;
+
+		try
+		{
+		    tmp.createHelperFilesystem(*snapshots[j], tmp.getSnapshotCurrent(), scd.empty);
+		}
+		catch (const Exception& e)
+		{
+		    SN_CAUGHT(e);
+
+		    y2err("creating snapshot for " << snappers[j]->configName() << " failed");
+		    snapshots[j].reset();
+		}
+		catch (...)
+		{
+		    y2err("creating snapshot for " << snappers[j]->configName() << " failed");
+		    snapshots[j].reset();
+		}
+	    }
+	};
+
+	boost::thread_group threads;
+
+	try
+	{
+	    for (size_t i = 0; i < std::min(n, max_create_threads); ++i)
+		threads.create_thread(worker);
+	}
+	catch (...)
+	{
+	    // The threads already running and this thread take over the
+	    // remaining work.
+
+	    y2err("creating thread failed");
+	}
+
+	worker();
+
+	threads.join_all();
+
+	for (size_t i = 0; i < n; ++i)
+	{
+	    if (!snapshots[i])
+		continue;
+
+	    try
+	    {
+		ret[i] = snappers[i]->snapshots.createHelperFinish(*snapshots[i], report);
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+
+		y2err("creating snapshot for " << snappers[i]->configName() << " failed");
+	    }
+	}
+
+	return ret;
+    }
+
+
     Snapshots::iterator
     Snapper::createSingleSnapshotOfDefault(const SCD& scd, Plugins::Report& report)
     {
@@ -251,6 +358,13 @@ namespace snapper
     }
 
 
+    void
+    Snapper::deleteSnapshots(const vector<Snapshots::iterator>& snapshots, Plugins::Report& report)
+    {
+	this->snapshots.deleteSnapshots(snapshots, report);
+    }
+
+
     ConfigInfo
     Snapper::getConfig(const string& config_name, const string& root_prefix)
     {
@@ -476,6 +590,8 @@ namespace snapper
 	    for (const string& tmp : infos_dir.entries(SDir::number_entries))
 		infos_dir.rmdir(tmp);
 
+	    infos_dir.unlink(LAST_NUMBER_NAME);
+
 	    // call ~SDir - although rmdir below (deleteConfig in LVM case) works on a
 	    // busy directory - better save than sorry
 	}
@@ -598,6 +714,13 @@ namespace snapper
     }
 
 
+    void
+    Snapper::removeOrphanedInfoDirs() const
+    {
+	snapshots.removeOrphanedInfoDirs();
+    }
+
+
     static void
     set_acl_permissions(acl_entry_t entry)
     {
@@ -856,12 +979,17 @@ namespace snapper
 	SDir general_dir = btrfs->openGeneralDir();
 
 	// Tests have shown that without a rescan and sync here the quota data
-	// is incorrect.
+	// is incorrect. The rescan is skipped if the qgroup generation did
+	// not change since the last rescan.
 
 	try
 	{
-	    quota_rescan(general_dir.fd());
-	    sync(general_dir.fd());
+	    if (!btrfs->isQGroupUsageRescanned())
+	    {
+		quota_rescan(general_dir.fd());
+		sync(general_dir.fd());
+		btrfs->setQGroupUsageRescanned();
+	    }
 	}
 	catch (...)
 	{
@@ -872,7 +1000,7 @@ namespace snapper
 
 	std::tie(quota_data.size, std::ignore) = general_dir.statvfs();
 
-	QGroupUsage qgroup_usage = qgroup_query_usage(general_dir.fd(), btrfs->getQGroup());
+	QGroupUsage qgroup_usage = btrfs->queryQGroupUsage(btrfs->getQGroup());
 	quota_data.used = qgroup_usage.exclusive;
 
 	y2mil("size:" << quota_data.size << " used:" << quota_data.used);
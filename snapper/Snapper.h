@@ -123,6 +123,20 @@ namespace snapper
 	Snapshots::iterator createSingleSnapshot(const SCD& scd, Plugins::Report& report);
 	Snapshots::iterator createSingleSnapshot(Snapshots::const_iterator parent, const SCD& scd,
 						 Plugins::Report& report);
+
+	/**
+	 * Create single snapshots of the current subvolume of several
+	 * configs. First the pre-action plugins run for all configs, then
+	 * the filesystem snapshots are created concurrently and finally
+	 * the info files are written and the post-action plugins run. So
+	 * the snapshots are taken as close together as possible.
+	 *
+	 * Returns for every snapper the new snapshot or end() of the
+	 * snapshots of the snapper if creating that snapshot failed.
+	 */
+	static vector<Snapshots::iterator> createSingleSnapshots(const vector<Snapper*>& snappers,
+								 const SCD& scd, Plugins::Report& report);
+
 	Snapshots::iterator createSingleSnapshotOfDefault(const SCD& scd, Plugins::Report& report);
 	Snapshots::iterator createPreSnapshot(const SCD& scd, Plugins::Report& report);
 	Snapshots::iterator createPostSnapshot(Snapshots::const_iterator pre, const SCD& scd,
@@ -132,6 +146,14 @@ namespace snapper
 
 	void deleteSnapshot(Snapshots::iterator snapshot, Plugins::Report& report);
 
+	/**
+	 * Delete several snapshots. All snapshots are checked before
+	 * anything is deleted. The filesystem snapshots are deleted
+	 * back-to-back followed by the metadata. Call syncFilesystem()
+	 * afterwards to wait for the deletion to complete.
+	 */
+	void deleteSnapshots(const vector<Snapshots::iterator>& snapshots, Plugins::Report& report);
+
 	const vector<string>& getIgnorePatterns() const { return ignore_patterns; }
 
 	static ConfigInfo getConfig(const string& config_name, const string& root_prefix);
@@ -153,6 +175,13 @@ namespace snapper
 
 	void syncFilesystem() const;
 
+	/**
+	 * Remove directories in the infos-dir not belonging to any
+	 * snapshot. Such directories can be left over since snapshot
+	 * numbers are all-time unique.
+	 */
+	void removeOrphanedInfoDirs() const;
+
 	void setupQuota();
 
 	void prepareQuota() const;
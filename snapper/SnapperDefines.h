@@ -40,6 +40,11 @@
 
 #define PLUGINS_DIR "/usr/lib/snapper/plugins"
 
+#define CACHE_DIR "/var/cache/snapper"
+#define SNBK_STATE_CACHE_DIR CACHE_DIR "/snbk"
+
+#define SNBK_LOCK_DIR "/run/snbk"
+
 #define DEV_DIR "/dev"
 #define DEV_MAPPER_DIR "/dev/mapper"
 
@@ -50,6 +55,9 @@
 #define SNAPSHOTS_NAME ".snapshots"
 #define SNAPSHOT_NAME "snapshot"
 
+// file in the infos-dir holding the highest snapshot number handed out
+#define LAST_NUMBER_NAME ".last-number"
+
 
 // commands - more in configure.ac
 
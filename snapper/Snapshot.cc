@@ -26,13 +26,19 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <cerrno>
 #include <cstring>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <boost/thread.hpp>
 
 #include "snapper/Snapshot.h"
 #include "snapper/Snapper.h"
 #include "snapper/AppUtil.h"
-#include "snapper/XmlFile.h"
+#include "snapper/InfoXml.h"
 #include "snapper/Filesystem.h"
 #ifdef ENABLE_BTRFS
 #include "snapper/Btrfs.h"
@@ -178,12 +184,10 @@ namespace snapper
 	if (!btrfs)
 	    SN_THROW(QuotaException("quota only supported with btrfs"));
 
-	SDir general_dir = btrfs->openGeneralDir();
-
 	subvolid_t subvolid = get_id(openSnapshotDir().fd());
 	qgroup_t qgroup = calc_qgroup(0, subvolid);
 
-	QGroupUsage qgroup_usage = qgroup_query_usage(general_dir.fd(), qgroup);
+	QGroupUsage qgroup_usage = btrfs->queryQGroupUsage(qgroup);
 
 	return qgroup_usage.exclusive;
 
@@ -234,99 +238,133 @@ namespace snapper
     Snapshots::~Snapshots() = default;
 
 
+    // Maximal number of threads used to read the snapshots.
+    static const unsigned int max_read_threads = 8;
+
+
     void
-    Snapshots::read()
+    Snapshots::readInfo(const SDir& infos_dir, const string& info, list<Snapshot>& snapshots) const
     {
-	SDir infos_dir = snapper->openInfosDir();
-
-	for (const string& info : infos_dir.entries(SDir::number_entries))
+	try
 	{
-	    try
+	    SDir info_dir(infos_dir, info);
+	    int fd = info_dir.open("info.xml", O_NOFOLLOW | O_CLOEXEC);
+	    if (fd < 0)
 	    {
-		SDir info_dir(infos_dir, info);
-		int fd = info_dir.open("info.xml", O_NOFOLLOW | O_CLOEXEC);
-		if (fd < 0)
-		{
-		    // Since we want all-time unique snapshots number we might have empty
-		    // directories. So do not raise an exception here.
+		// Since we want all-time unique snapshots number we might have empty
+		// directories. So do not raise an exception here.
 
-		    continue;
-		}
+		return;
+	    }
 
-		XmlFile file(fd, "");
+	    InfoXml info_xml;
+	    info_xml.read(fd);
 
-		const xmlNode* node = file.getRootElement();
+	    SnapshotType type;
+	    if (!info_xml.has_type || !toValue(info_xml.type, type, true))
+	    {
+		y2err("type missing or invalid. not adding snapshot " << info);
+		return;
+	    }
 
-		string tmp;
+	    unsigned int num = info_xml.num;
+	    if (!info_xml.has_num || num == 0)
+	    {
+		y2err("num missing or invalid. not adding snapshot " << info);
+		return;
+	    }
 
-		SnapshotType type;
-		if (!getChildValue(node, "type", tmp) || !toValue(tmp, type, true))
-		{
-		    y2err("type missing or invalid. not adding snapshot " << info);
-		    continue;
-		}
+	    time_t date;
+	    if (!info_xml.has_date || (date = scan_datetime(info_xml.date, true)) == (time_t)(-1))
+	    {
+		y2err("date missing or invalid. not adding snapshot " << info);
+		return;
+	    }
 
-		unsigned int num;
-		if (!getChildValue(node, "num", num) || num == 0)
-		{
-		    y2err("num missing or invalid. not adding snapshot " << info);
-		    continue;
-		}
+	    Snapshot snapshot(snapper, type, num, date);
 
-		time_t date;
-		if (!getChildValue(node, "date", tmp) || (date = scan_datetime(tmp, true)) == (time_t)(-1))
-		{
-		    y2err("date missing or invalid. not adding snapshot " << info);
-		    continue;
-		}
+	    info >> num;
+	    if (num != snapshot.num)
+	    {
+		y2err("num mismatch. not adding snapshot " << info);
+		return;
+	    }
 
-		Snapshot snapshot(snapper, type, num, date);
+	    snapshot.uid = info_xml.uid;
+	    snapshot.pre_num = info_xml.pre_num;
+	    snapshot.description = info_xml.description;
+	    snapshot.cleanup = info_xml.cleanup;
+	    snapshot.userdata = info_xml.userdata;
 
-		info >> num;
-		if (num != snapshot.num)
-		{
-		    y2err("num mismatch. not adding snapshot " << info);
-		    continue;
-		}
+	    const Filesystem* filesystem = snapper->getFilesystem();
 
-		getChildValue(node, "uid", snapshot.uid);
+	    if (!filesystem->checkSnapshot(snapshot.num))
+	    {
+		y2err("snapshot check failed. not adding snapshot " << info);
+		return;
+	    }
 
-		getChildValue(node, "pre_num", snapshot.pre_num);
+	    snapshot.read_only = filesystem->isSnapshotReadOnly(snapshot.num);
 
-		getChildValue(node, "description", snapshot.description);
+	    snapshots.push_back(snapshot);
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
 
-		getChildValue(node, "cleanup", snapshot.cleanup);
+	    y2err("loading " << info << " failed");
+	}
+    }
 
-		const vector<const xmlNode*> l = getChildNodes(node, "userdata");
-		for (vector<const xmlNode*>::const_iterator it2 = l.begin(); it2 != l.end(); ++it2)
-		{
-		    string key, value;
-		    getChildValue(*it2, "key", key);
-		    getChildValue(*it2, "value", value);
-		    if (!key.empty())
-			snapshot.userdata[key] = value;
-		}
 
-		const Filesystem* filesystem = snapper->getFilesystem();
+    void
+    Snapshots::read()
+    {
+	SDir infos_dir = snapper->openInfosDir();
+
+	const vector<string> infos = infos_dir.entries(SDir::number_entries);
+
+	// Reading a snapshot involves parsing the info.xml and querying the
+	// filesystem (an ioctl for btrfs, possibly running lvs for LVM). So
+	// distribute the work on a few threads. Each thread collects its
+	// snapshots in its own list, the lists are merged afterwards.
+
+	const unsigned int num_threads = std::min<size_t>(infos.size(), std::max(1U,
+	    std::min(boost::thread::hardware_concurrency(), max_read_threads)));
+
+	vector<list<Snapshot>> results(num_threads);
+	vector<std::exception_ptr> errors(num_threads);
 
-		if (!filesystem->checkSnapshot(snapshot.num))
+	std::atomic<size_t> next(0);
+
+	boost::thread_group threads;
+
+	for (unsigned int i = 0; i < num_threads; ++i)
+	{
+	    threads.create_thread([this, &infos_dir, &infos, &next, &results, &errors, i]() {
+		try
 		{
-		    y2err("snapshot check failed. not adding snapshot " << info);
-		    continue;
+		    for (size_t n = next++; n < infos.size(); n = next++)
+			readInfo(infos_dir, infos[n], results[i]);
 		}
+		catch (...)
+		{
+		    errors[i] = std::current_exception();
+		}
+	    });
+	}
 
-		snapshot.read_only = filesystem->isSnapshotReadOnly(snapshot.num);
+	threads.join_all();
 
-		entries.push_back(snapshot);
-	    }
-	    catch (const Exception& e)
-	    {
-		SN_CAUGHT(e);
-
-		y2err("loading " << info << " failed");
-	    }
+	for (const std::exception_ptr& error : errors)
+	{
+	    if (error)
+		std::rethrow_exception(error);
 	}
 
+	for (list<Snapshot>& result : results)
+	    entries.splice(entries.end(), result);
+
 	entries.sort();
 
 	y2mil("found " << entries.size() << " snapshots");
@@ -339,6 +377,13 @@ namespace snapper
 	time_t t0 = time(NULL);
 	time_t t1 = (time_t)(-1);
 
+	// Number of post snapshots for every pre number.
+
+	map<unsigned int, int> num_posts;
+	for (const Snapshot& snapshot : entries)
+	    if (snapshot.pre_num != 0)
+		num_posts[snapshot.pre_num]++;
+
 	for (const_iterator i1 = begin(); i1 != end(); ++i1)
 	{
 	    switch (i1->type)
@@ -350,12 +395,9 @@ namespace snapper
 
 		case PRE:
 		{
-		    int n = 0;
-		    for (const_iterator i2 = begin(); i2 != end(); ++i2)
-			if (i2->pre_num == i1->num)
-			    n++;
-		    if (n > 1)
-			y2err("pre-num " << i1->num << " has " << n << " post-nums");
+		    map<unsigned int, int>::const_iterator it = num_posts.find(i1->num);
+		    if (it != num_posts.end() && it->second > 1)
+			y2err("pre-num " << i1->num << " has " << it->second << " post-nums");
 		}
 		break;
 
@@ -425,23 +467,53 @@ namespace snapper
 	    y2err("reading failed");
 	}
 
+	index_by_num.clear();
+	index_by_pre_num.clear();
+
+	for (iterator it = entries.begin(); it != entries.end(); ++it)
+	    addToIndex(it);
+
 	check();
     }
 
 
+    void
+    Snapshots::addToIndex(iterator snapshot)
+    {
+	index_by_num[snapshot->num] = snapshot;
+
+	// In case of several post snapshots for one pre snapshot (only
+	// possible with broken info files) keep the first one like the
+	// linear search did.
+
+	if (snapshot->type == POST)
+	    index_by_pre_num.emplace(snapshot->pre_num, snapshot);
+    }
+
+
+    void
+    Snapshots::removeFromIndex(const_iterator snapshot)
+    {
+	index_by_num.erase(snapshot->num);
+
+	if (snapshot->type == POST)
+	{
+	    std::unordered_map<unsigned int, iterator>::iterator it = index_by_pre_num.find(snapshot->pre_num);
+	    if (it != index_by_pre_num.end() && it->second == snapshot)
+		index_by_pre_num.erase(it);
+	}
+    }
+
+
     Snapshots::iterator
     Snapshots::findPost(const_iterator pre)
     {
 	if (pre == entries.end() || pre->isCurrent() || pre->getType() != PRE)
 	    SN_THROW(IllegalSnapshotException());
 
-	for (iterator it = begin(); it != end(); ++it)
-	{
-	    if (it->getType() == POST && it->getPreNum() == pre->getNum())
-		return it;
-	}
+	std::unordered_map<unsigned int, iterator>::const_iterator it = index_by_pre_num.find(pre->getNum());
 
-	return end();
+	return it != index_by_pre_num.end() ? it->second : end();
     }
 
 
@@ -451,13 +523,9 @@ namespace snapper
 	if (pre == entries.end() || pre->isCurrent() || pre->getType() != PRE)
 	    SN_THROW(IllegalSnapshotException());
 
-	for (const_iterator it = begin(); it != end(); ++it)
-	{
-	    if (it->getType() == POST && it->getPreNum() == pre->getNum())
-		return it;
-	}
+	std::unordered_map<unsigned int, iterator>::const_iterator it = index_by_pre_num.find(pre->getNum());
 
-	return end();
+	return it != index_by_pre_num.end() ? it->second : end();
     }
 
 
@@ -484,25 +552,37 @@ namespace snapper
     unsigned int
     Snapshots::nextNumber() const
     {
-	// We want all-time unique snapshot numbers.
+	// We want all-time unique snapshot numbers. The highest number handed
+	// out so far is saved in the infos-dir. Only if that file is missing
+	// or invalid all entries of the infos-dir are scanned. Directories not
+	// belonging to any snapshot are removed by removeOrphanedInfoDirs().
 
-	SDir infos_dir = snapper->openInfosDir();
+	bool unique_numbers = true;
+	snapper->getConfigInfo().get_value("UNIQUE_NUMBERS", unique_numbers);
 
-	// Numbers of directories (and files) found in infos-dir.
+	SDir infos_dir = snapper->openInfosDir();
 
-	vector<unsigned int> nums;
-	for (const string& tmp : infos_dir.entries(SDir::number_entries))
-	    nums.push_back(stoi(tmp));
+	unsigned int num = entries.empty() ? 0 : entries.rbegin()->num;
 
-	// Set num to next available free number. All entries should also be included in
-	// nums but better be save.
+	if (unique_numbers)
+	{
+	    unsigned int last_num = 0;
+	    if (readLastNumber(infos_dir, last_num))
+	    {
+		num = std::max(num, last_num);
+	    }
+	    else
+	    {
+		// Numbers of directories (and files) found in infos-dir. All entries
+		// should also be included in nums but better be save.
 
-	unsigned int num = entries.empty() ? 0 : entries.rbegin()->num;
-	for (unsigned int tmp : nums)
-	    num = std::max(num, tmp);
+		for (const string& tmp : infos_dir.entries(SDir::number_entries))
+		    num = std::max(num, (unsigned int) stoi(tmp));
+	    }
+	}
 
-	// Now try to create the next directory. EEXIST should not happen since we just
-	// looked at all directories but better be save.
+	// Now try to create the next directory. EEXIST can happen if the saved
+	// number is outdated, e.g. after a crash.
 
 	while (true)
 	{
@@ -523,56 +603,160 @@ namespace snapper
 
 	infos_dir.chmod(decString(num), 0755, 0);
 
-	// Now try to remove directories not belonging to any snapshot. The new num is not
-	// included in nums.
-
-	for (unsigned int tmp : nums)
+	if (unique_numbers)
 	{
-	    if (find(tmp) == end())
-		infos_dir.rmdir(decString(tmp));
+	    try
+	    {
+		writeLastNumber(infos_dir, num);
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+
+		// Not fatal, next time the infos-dir is scanned again.
+
+		infos_dir.unlink(LAST_NUMBER_NAME);
+	    }
 	}
 
 	return num;
     }
 
 
+    bool
+    Snapshots::readLastNumber(const SDir& infos_dir, unsigned int& num) const
+    {
+	int fd = infos_dir.open(LAST_NUMBER_NAME, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd < 0)
+	{
+	    if (errno != ENOENT)
+		y2err("open '" LAST_NUMBER_NAME "' failed errno: " << errno << " (" << stringerror(errno) << ")");
+
+	    return false;
+	}
+
+	FdCloser fd_closer(fd);
+
+	char buffer[32];
+	ssize_t r = ::read(fd, buffer, sizeof(buffer) - 1);
+	if (r <= 0)
+	{
+	    y2err("read '" LAST_NUMBER_NAME "' failed");
+	    return false;
+	}
+
+	buffer[r] = '\0';
+
+	char* end;
+	errno = 0;
+	unsigned long tmp = strtoul(buffer, &end, 10);
+	if (errno != 0 || end == buffer || (*end != '\n' && *end != '\0') || tmp > UINT_MAX)
+	{
+	    y2err("content of '" LAST_NUMBER_NAME "' invalid");
+	    return false;
+	}
+
+	num = tmp;
+
+	return true;
+    }
+
+
     void
-    Snapshot::writeInfo() const
+    Snapshots::writeLastNumber(const SDir& infos_dir, unsigned int num) const
     {
-	XmlFile xml;
-	xmlNode* node = xmlNewNode("snapshot");
-	xml.setRootElement(node);
+	// Write to temporary file and rename to be crash safe.
 
-	setChildValue(node, "type", toString(type));
+	string tmp_name = LAST_NUMBER_NAME ".tmp-XXXXXX";
 
-	setChildValue(node, "num", num);
+	int fd = infos_dir.mktemp(tmp_name);
+	if (fd < 0)
+	    SN_THROW(IOErrorException(sformat("SDir::mktemp failed, errno:%d (%s)", errno,
+					      stringerror(errno).c_str())));
 
-	setChildValue(node, "date", datetime(date, true, true));
+	FdCloser fd_closer(fd);
 
-	if (uid != 0)
-	    setChildValue(node, "uid", uid);
+	fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
-	if (type == POST)
-	    setChildValue(node, "pre_num", pre_num);
+	const string content = decString(num) + "\n";
 
-	if (!description.empty())
-	    setChildValue(node, "description", description);
+	if (::write(fd, content.c_str(), content.size()) != (ssize_t) content.size() || fsync(fd) != 0 ||
+	    fd_closer.close() != 0)
+	{
+	    int errnum = errno;
+	    infos_dir.unlink(tmp_name);
+	    SN_THROW(IOErrorException(sformat("writing '%s' failed, errno:%d (%s)", tmp_name.c_str(),
+					      errnum, stringerror(errnum).c_str())));
+	}
 
-	if (!cleanup.empty())
-	    setChildValue(node, "cleanup", cleanup);
+	if (infos_dir.rename(tmp_name, LAST_NUMBER_NAME) != 0)
+	{
+	    int errnum = errno;
+	    infos_dir.unlink(tmp_name);
+	    SN_THROW(IOErrorException(sformat("rename '%s' failed, errno:%d (%s)", tmp_name.c_str(),
+					      errnum, stringerror(errnum).c_str())));
+	}
 
-	for (map<string, string>::const_iterator it = userdata.begin(); it != userdata.end(); ++it)
+	infos_dir.fsync();
+    }
+
+
+    void
+    Snapshots::removeOrphanedInfoDirs() const
+    {
+	// Since we want all-time unique snapshot numbers we might have directories not
+	// belonging to any snapshot. Remove them but keep the directory with the
+	// highest number and directories with a number not lower than the saved
+	// highest number (possibly just created by another process).
+
+	SDir infos_dir = snapper->openInfosDir();
+
+	vector<unsigned int> nums;
+	for (const string& tmp : infos_dir.entries(SDir::number_entries))
+	    nums.push_back(stoi(tmp));
+
+	if (nums.empty())
+	    return;
+
+	unsigned int keep = *std::max_element(nums.begin(), nums.end());
+
+	unsigned int last_num = 0;
+	if (readLastNumber(infos_dir, last_num))
+	    keep = std::min(keep, last_num);
+
+	for (unsigned int tmp : nums)
 	{
-	    xmlNode* userdata_node = xmlNewChild(node, "userdata");
-	    setChildValue(userdata_node, "key", it->first);
-	    setChildValue(userdata_node, "value", it->second);
+	    if (tmp < keep && find(tmp) == end())
+		infos_dir.rmdir(decString(tmp));
 	}
+    }
+
+
+    void
+    Snapshot::writeInfo() const
+    {
+	InfoXml info_xml;
+
+	info_xml.type = toString(type);
+	info_xml.num = num;
+	info_xml.date = datetime(date, true, true);
+	info_xml.uid = uid;
+
+	if (type == POST)
+	    info_xml.pre_num = pre_num;
+
+	info_xml.description = description;
+	info_xml.cleanup = cleanup;
+	info_xml.userdata = userdata;
 
 	string file_name = "info.xml";
 	string tmp_name = file_name + ".tmp-XXXXXX";
 
 	SDir info_dir = openInfoDir();
 
+	// The checksum file must never belong to an older info.xml.
+	remove_info_xml_checksum(info_dir);
+
 	int fd = info_dir.mktemp(tmp_name);
 	if (fd < 0)
 	    SN_THROW(IOErrorException(sformat("SDir::mktemp failed, errno:%d (%s)", errno,
@@ -582,7 +766,7 @@ namespace snapper
 
 	try
 	{
-	    xml.save(fd);
+	    info_xml.write(fd);
 	}
 	catch (const Exception& e)
 	{
@@ -600,6 +784,16 @@ namespace snapper
 					      stringerror(errno).c_str())));
 	}
 
+	// Store the checksum so that snbk does not have to compute it.
+	try
+	{
+	    write_info_xml_checksum(info_dir, info_xml.checksum());
+	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+	}
+
 	info_dir.fsync();
     }
 
@@ -689,6 +883,15 @@ namespace snapper
 
     Snapshots::iterator
     Snapshots::createSingleSnapshot(const SCD& scd, Plugins::Report& report)
+    {
+	Snapshot snapshot = newSingleSnapshot(scd);
+
+	return createHelper(snapshot, getSnapshotCurrent(), scd.empty, report);
+    }
+
+
+    Snapshot
+    Snapshots::newSingleSnapshot(const SCD& scd) const
     {
 	checkUserdata(scd.userdata);
 
@@ -699,7 +902,7 @@ namespace snapper
 	snapshot.cleanup = scd.cleanup;
 	snapshot.userdata = scd.userdata;
 
-	return createHelper(snapshot, getSnapshotCurrent(), scd.empty, report);
+	return snapshot;
     }
 
 
@@ -775,11 +978,27 @@ namespace snapper
     Snapshots::iterator
     Snapshots::createHelper(Snapshot& snapshot, const_iterator parent, bool empty, Plugins::Report& report)
     {
-	// parent == end indicates the btrfs default subvolume. Unclean, but
-	// adding a special snapshot like current needs too many API changes.
+	createHelperPrepare(snapshot, report);
+
+	createHelperFilesystem(snapshot, parent, empty);
 
+	return createHelperFinish(snapshot, report);
+    }
+
+
+    void
+    Snapshots::createHelperPrepare(Snapshot& snapshot, Plugins::Report& report) const
+    {
 	Plugins::create_snapshot(Plugins::Stage::PRE_ACTION, snapper->subvolumeDir(), snapper->getFilesystem(),
 				 snapshot, report);
+    }
+
+
+    void
+    Snapshots::createHelperFilesystem(Snapshot& snapshot, const_iterator parent, bool empty) const
+    {
+	// parent == end indicates the btrfs default subvolume. Unclean, but
+	// adding a special snapshot like current needs too many API changes.
 
 	try
 	{
@@ -797,7 +1016,12 @@ namespace snapper
 
 	    SN_RETHROW(e);
 	}
+    }
 
+
+    Snapshots::iterator
+    Snapshots::createHelperFinish(Snapshot& snapshot, Plugins::Report& report)
+    {
 	try
 	{
 	    snapshot.writeInfo();
@@ -816,7 +1040,11 @@ namespace snapper
 	Plugins::create_snapshot(Plugins::Stage::POST_ACTION, snapper->subvolumeDir(), snapper->getFilesystem(),
 				 snapshot, report);
 
-	return entries.insert(entries.end(), snapshot);
+	iterator ret = entries.insert(entries.end(), snapshot);
+
+	addToIndex(ret);
+
+	return ret;
     }
 
 
@@ -845,38 +1073,116 @@ namespace snapper
     void
     Snapshots::deleteSnapshot(iterator snapshot, Plugins::Report& report)
     {
-	if (snapshot == entries.end() || snapshot->isCurrent() || snapshot->isDefault() ||
-	    snapshot->isActive())
-	    SN_THROW(IllegalSnapshotException());
+	deleteSnapshots({ snapshot }, report);
+    }
 
-	Plugins::delete_snapshot(Plugins::Stage::PRE_ACTION, snapper->subvolumeDir(), snapper->getFilesystem(),
-				 *snapshot, report);
 
-	snapshot->deleteFilesystemSnapshot();
-	snapshot->deleteFilelists();
+    void
+    Snapshots::deleteSnapshots(const vector<iterator>& snapshots, Plugins::Report& report)
+    {
+	// Check all snapshots before deleting anything.
+
+	for (const iterator& snapshot : snapshots)
+	{
+	    if (snapshot == entries.end() || snapshot->isCurrent() || snapshot->isDefault() ||
+		snapshot->isActive())
+		SN_THROW(IllegalSnapshotException());
+	}
 
-	SDir info_dir = snapshot->openInfoDir();
-	if (info_dir.unlink("info.xml") < 0)
-	    y2err("unlink 'info.xml' failed errno: " << errno << " (" << stringerror(errno) << ")");
+	bool unique_numbers = true;
+	snapper->getConfigInfo().get_value("UNIQUE_NUMBERS", unique_numbers);
 
 	// If want all-time unique snapshot numbers keep directory of snapshot with
 	// highest number.
 
-	bool unique_numbers = true;
-	snapper->getConfigInfo().get_value("UNIQUE_NUMBERS", unique_numbers);
+	const unsigned int highest_num = entries.rbegin()->num;
+
+	// First delete all filesystem snapshots back-to-back. For btrfs the
+	// subvolumes are only queued for the cleaner and a later sync waits
+	// for all of them at once.
 
-	if (!unique_numbers || snapshot->num != entries.rbegin()->num)
+	vector<iterator> deleted;
+
+	try
 	{
-	    SDir infos_dir = snapper->openInfosDir();
-	    if (infos_dir.rmdir(decString(snapshot->getNum())) < 0)
-		y2err("rmdir '" << snapshot->getNum() << "' failed errno: " << errno << " (" <<
-		      stringerror(errno) << ")");
+	    for (const iterator& snapshot : snapshots)
+	    {
+		if (std::find(deleted.begin(), deleted.end(), snapshot) != deleted.end())
+		    continue;
+
+		Plugins::delete_snapshot(Plugins::Stage::PRE_ACTION, snapper->subvolumeDir(),
+					 snapper->getFilesystem(), *snapshot, report);
+
+		snapshot->deleteFilesystemSnapshot();
+
+		deleted.push_back(snapshot);
+	    }
 	}
+	catch (const Exception& e)
+	{
+	    SN_CAUGHT(e);
+
+	    deleteMetadata(deleted, unique_numbers, highest_num, report);
+
+	    SN_RETHROW(e);
+	}
+
+	deleteMetadata(deleted, unique_numbers, highest_num, report);
+
+	// Deleting is also the cleanup path, so also get rid of directories left
+	// over by earlier deletes. Failing to do so is not fatal.
+
+	if (unique_numbers)
+	{
+	    try
+	    {
+		removeOrphanedInfoDirs();
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+	    }
+	}
+    }
 
-	Plugins::delete_snapshot(Plugins::Stage::POST_ACTION, snapper->subvolumeDir(), snapper->getFilesystem(),
-				 *snapshot, report);
 
-	entries.erase(snapshot);
+    void
+    Snapshots::deleteMetadata(const vector<iterator>& snapshots, bool unique_numbers,
+			      unsigned int highest_num, Plugins::Report& report)
+    {
+	SDir infos_dir = snapper->openInfosDir();
+
+	for (const iterator& snapshot : snapshots)
+	{
+	    snapshot->deleteFilelists();
+
+	    SDir info_dir = snapshot->openInfoDir();
+	    if (info_dir.unlink("info.xml") < 0)
+		y2err("unlink 'info.xml' failed errno: " << errno << " (" << stringerror(errno) << ")");
+
+	    try
+	    {
+		remove_info_xml_checksum(info_dir);
+	    }
+	    catch (const Exception& e)
+	    {
+		SN_CAUGHT(e);
+	    }
+
+	    if (!unique_numbers || snapshot->num != highest_num)
+	    {
+		if (infos_dir.rmdir(decString(snapshot->getNum())) < 0)
+		    y2err("rmdir '" << snapshot->getNum() << "' failed errno: " << errno << " (" <<
+			  stringerror(errno) << ")");
+	    }
+
+	    Plugins::delete_snapshot(Plugins::Stage::POST_ACTION, snapper->subvolumeDir(),
+				     snapper->getFilesystem(), *snapshot, report);
+
+	    removeFromIndex(snapshot);
+
+	    entries.erase(snapshot);
+	}
     }
 
 
@@ -907,25 +1213,21 @@ namespace snapper
     }
 
 
-    struct num_is
-    {
-	num_is(unsigned int num) : num(num) {}
-	bool operator()(const Snapshot& s) const { return s.getNum() == num; }
-	const unsigned int num;
-    };
-
-
     Snapshots::iterator
     Snapshots::find(unsigned int num)
     {
-	return find_if(entries.begin(), entries.end(), num_is(num));
+	std::unordered_map<unsigned int, iterator>::const_iterator it = index_by_num.find(num);
+
+	return it != index_by_num.end() ? it->second : end();
     }
 
 
     Snapshots::const_iterator
     Snapshots::find(unsigned int num) const
     {
-	return find_if(entries.begin(), entries.end(), num_is(num));
+	std::unordered_map<unsigned int, iterator>::const_iterator it = index_by_num.find(num);
+
+	return it != index_by_num.end() ? it->second : end();
     }
 
 }
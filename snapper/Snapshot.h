@@ -31,6 +31,8 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
+#include <unordered_map>
 
 #include "snapper/Exception.h"
 #include "snapper/Plugins.h"
@@ -41,6 +43,7 @@ namespace snapper
     using std::string;
     using std::list;
     using std::map;
+    using std::vector;
 
 
     class Snapper;
@@ -224,6 +227,9 @@ namespace snapper
 	Snapshots(const Snapper* snapper);
 	~Snapshots();
 
+	Snapshots(const Snapshots&) = delete;
+	Snapshots& operator=(const Snapshots&) = delete;
+
 	typedef list<Snapshot>::iterator iterator;
 	typedef list<Snapshot>::const_iterator const_iterator;
 	typedef list<Snapshot>::size_type size_type;
@@ -276,11 +282,20 @@ namespace snapper
 
 	void read();
 
+	void readInfo(const SDir& infos_dir, const string& info, list<Snapshot>& snapshots) const;
+
 	void check() const;
 
 	void checkUserdata(const map<string, string>& userdata) const;
 
 	iterator createSingleSnapshot(const SCD& scd, Plugins::Report& report);
+
+	/**
+	 * Create the Snapshot object for a new single snapshot, including
+	 * the number.
+	 */
+	Snapshot newSingleSnapshot(const SCD& scd) const;
+
 	iterator createSingleSnapshot(const_iterator parent, const SCD& scd, Plugins::Report& report);
 	iterator createSingleSnapshotOfDefault(const SCD& scd, Plugins::Report& report);
 	iterator createPreSnapshot(const SCD& scd, Plugins::Report& report);
@@ -288,16 +303,47 @@ namespace snapper
 
 	iterator createHelper(Snapshot& snapshot, const_iterator parent, bool empty, Plugins::Report& report);
 
+	/**
+	 * The steps of createHelper(): running the pre-action plugins,
+	 * creating the filesystem snapshot and finally writing the info
+	 * file, running the post-action plugins and adding the snapshot.
+	 */
+	void createHelperPrepare(Snapshot& snapshot, Plugins::Report& report) const;
+	void createHelperFilesystem(Snapshot& snapshot, const_iterator parent, bool empty) const;
+	iterator createHelperFinish(Snapshot& snapshot, Plugins::Report& report);
+
 	void modifySnapshot(iterator snapshot, const SMD& smd, Plugins::Report& report);
 
 	void deleteSnapshot(iterator snapshot, Plugins::Report& report);
 
+	void deleteSnapshots(const vector<iterator>& snapshots, Plugins::Report& report);
+
+	void deleteMetadata(const vector<iterator>& snapshots, bool unique_numbers,
+			    unsigned int highest_num, Plugins::Report& report);
+
 	unsigned int nextNumber() const;
 
+	bool readLastNumber(const SDir& infos_dir, unsigned int& num) const;
+	void writeLastNumber(const SDir& infos_dir, unsigned int num) const;
+
+	void removeOrphanedInfoDirs() const;
+
+	void addToIndex(iterator snapshot);
+	void removeFromIndex(const_iterator snapshot);
+
 	const Snapper* snapper;
 
 	list<Snapshot> entries;
 
+	/**
+	 * Indices for fast lookup of entries by number and of post
+	 * snapshots by the number of the pre snapshot. Iterators of lists
+	 * are stable so the indices only have to be updated when entries
+	 * are added or removed.
+	 */
+	std::unordered_map<unsigned int, iterator> index_by_num;
+	std::unordered_map<unsigned int, iterator> index_by_pre_num;
+
     };
 
 }
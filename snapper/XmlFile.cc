@@ -44,7 +44,14 @@ namespace snapper
     {
 	XmlErrorSetup()
 	{
+	    // Initialize the library here since files may be parsed in
+	    // several threads (see Snapshots::read()). The error function
+	    // is per thread so also set the default for new threads.
+
+	    xmlInitParser();
+
 	    xmlSetGenericErrorFunc(strdup("snapper"), xml_error_func_ptr);
+	    xmlThrDefSetGenericErrorFunc(strdup("snapper"), xml_error_func_ptr);
 	}
     };
 
@@ -22,7 +22,7 @@
 
 #include <time.h>
 
-#include "equal-date.h"
+#include "snapper/equal-date.h"
 
 
 #define isleapyear(year) \
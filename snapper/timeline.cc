@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#include <algorithm>
+
+#include "snapper/timeline.h"
+#include "snapper/equal-date.h"
+
+
+namespace snapper
+{
+    using namespace std;
+
+
+    namespace
+    {
+
+	typedef bool (*equal_fnc)(const struct tm& tmp1, const struct tm& tmp2);
+
+
+	void
+	keep_period(const vector<TimelineEntry>& entries, equal_fnc equal, size_t limit,
+		    vector<bool>& keep)
+	{
+	    const size_t n = entries.size();
+
+	    if (limit == 0 || n == 0)
+		return;
+
+	    // Going backwards the minimal date of the entries following an entry
+	    // in the same period is known. Since the equal functions are
+	    // equivalence relations comparing neighbours is enough.
+
+	    vector<bool> first(n, true);
+
+	    bool has_following = false;
+	    time_t min_following = 0;
+
+	    for (size_t i = n - 1; i-- > 0; )
+	    {
+		if (equal(entries[i].tm, entries[i + 1].tm))
+		{
+		    min_following = has_following ? min(min_following, entries[i + 1].date) :
+			entries[i + 1].date;
+		    has_following = true;
+		}
+		else
+		{
+		    has_following = false;
+		}
+
+		first[i] = !has_following || entries[i].date <= min_following;
+	    }
+
+	    size_t num = 0;
+
+	    for (size_t i = 0; i < n && num < limit; ++i)
+	    {
+		if (first[i])
+		{
+		    ++num;
+		    keep[i] = true;
+		}
+	    }
+	}
+
+    }
+
+
+    vector<bool>
+    timeline_keep(const vector<TimelineEntry>& entries, const TimelineLimits& limits)
+    {
+	vector<bool> keep(entries.size(), false);
+
+	keep_period(entries, equal_hour, limits.hourly, keep);
+	keep_period(entries, equal_day, limits.daily, keep);
+	keep_period(entries, equal_week, limits.weekly, keep);
+	keep_period(entries, equal_month, limits.monthly, keep);
+	keep_period(entries, equal_quarter, limits.quarterly, keep);
+	keep_period(entries, equal_year, limits.yearly, keep);
+
+	return keep;
+    }
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact Novell, Inc.
+ *
+ * To contact Novell about this file by physical or electronic mail, you may
+ * find current contact information at www.novell.com.
+ */
+
+
+#ifndef SNAPPER_TIMELINE_H
+#define SNAPPER_TIMELINE_H
+
+
+#include <time.h>
+#include <vector>
+
+
+namespace snapper
+{
+    using std::vector;
+
+
+    struct TimelineEntry
+    {
+	time_t date;
+	struct tm tm;		// broken-down date
+    };
+
+
+    struct TimelineLimits
+    {
+	size_t hourly = 0;
+	size_t daily = 0;
+	size_t weekly = 0;
+	size_t monthly = 0;
+	size_t quarterly = 0;
+	size_t yearly = 0;
+    };
+
+
+    /*
+     * Calculates which timeline snapshots to keep. The entries must be ordered
+     * from the newest to the oldest snapshot (by number). An entry is the first
+     * of a period if no entry following it in the same period is older. For
+     * each period the first entries are kept up to the limit.
+     *
+     * Runs in linear time since only neighbouring entries are compared.
+     */
+    vector<bool>
+    timeline_keep(const vector<TimelineEntry>& entries, const TimelineLimits& limits);
+
+}
+
+
+#endif
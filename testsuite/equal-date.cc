@@ -4,7 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
-#include "../client/utils/equal-date.h"
+#include "../snapper/equal-date.h"
 #include "../snapper/AppUtil.h"
 
 using namespace snapper;
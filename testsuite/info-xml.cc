@@ -0,0 +1,255 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE info_xml
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+
+#include "snapper/InfoXml.h"
+#include "snapper/XmlFile.h"
+#include "snapper/FileUtils.h"
+#include "snapper/Sha256.h"
+#include "snapper/Exception.h"
+
+using namespace std;
+using namespace snapper;
+
+
+// Writes the info.xml using XmlFile like Snapshot::writeInfo() did before
+// InfoXml was introduced.
+
+string
+write_with_xml_file(const InfoXml& info_xml)
+{
+    XmlFile xml;
+    xmlNode* node = snapper::xmlNewNode("snapshot");
+    xml.setRootElement(node);
+
+    setChildValue(node, "type", info_xml.type);
+    setChildValue(node, "num", info_xml.num);
+    setChildValue(node, "date", info_xml.date);
+
+    if (info_xml.uid != 0)
+	setChildValue(node, "uid", info_xml.uid);
+
+    if (info_xml.pre_num != 0)
+	setChildValue(node, "pre_num", info_xml.pre_num);
+
+    if (!info_xml.description.empty())
+	setChildValue(node, "description", info_xml.description);
+
+    if (!info_xml.cleanup.empty())
+	setChildValue(node, "cleanup", info_xml.cleanup);
+
+    for (const map<string, string>::value_type& value : info_xml.userdata)
+    {
+	xmlNode* userdata_node = snapper::xmlNewChild(node, "userdata");
+	setChildValue(userdata_node, "key", value.first);
+	setChildValue(userdata_node, "value", value.second);
+    }
+
+    char name[] = "/tmp/info-xml-XXXXXX";
+    int fd = mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+
+    xml.save(fd);
+
+    ifstream s(name);
+    ostringstream ret;
+    ret << s.rdbuf();
+
+    unlink(name);
+
+    return ret.str();
+}
+
+
+InfoXml
+read(const string& content)
+{
+    char name[] = "/tmp/info-xml-XXXXXX";
+    int fd = mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+
+    BOOST_REQUIRE(write(fd, content.data(), content.size()) == (ssize_t) content.size());
+    lseek(fd, 0, SEEK_SET);
+    unlink(name);
+
+    InfoXml info_xml;
+    info_xml.read(fd);
+    return info_xml;
+}
+
+
+void
+check_equal(const InfoXml& a, const InfoXml& b)
+{
+    BOOST_CHECK_EQUAL(a.type, b.type);
+    BOOST_CHECK_EQUAL(a.num, b.num);
+    BOOST_CHECK_EQUAL(a.date, b.date);
+    BOOST_CHECK_EQUAL(a.uid, b.uid);
+    BOOST_CHECK_EQUAL(a.pre_num, b.pre_num);
+    BOOST_CHECK_EQUAL(a.description, b.description);
+    BOOST_CHECK_EQUAL(a.cleanup, b.cleanup);
+    BOOST_CHECK(a.userdata == b.userdata);
+}
+
+
+void
+check_round_trip(const InfoXml& info_xml)
+{
+    string content = info_xml.write();
+
+    BOOST_CHECK_EQUAL(content, write_with_xml_file(info_xml));
+
+    InfoXml tmp = read(content);
+
+    BOOST_CHECK(tmp.has_type);
+    BOOST_CHECK(tmp.has_num);
+    BOOST_CHECK(tmp.has_date);
+
+    check_equal(tmp, info_xml);
+}
+
+
+BOOST_AUTO_TEST_CASE(single)
+{
+    InfoXml info_xml;
+    info_xml.type = "single";
+    info_xml.num = 1;
+    info_xml.date = "2026-01-14 08:15:32";
+    info_xml.description = "first root filesystem";
+
+    check_round_trip(info_xml);
+
+    BOOST_CHECK_EQUAL(info_xml.write(),
+		      "<?xml version=\"1.0\"?>\n"
+		      "<snapshot>\n"
+		      "  <type>single</type>\n"
+		      "  <num>1</num>\n"
+		      "  <date>2026-01-14 08:15:32</date>\n"
+		      "  <description>first root filesystem</description>\n"
+		      "</snapshot>\n");
+}
+
+
+BOOST_AUTO_TEST_CASE(post)
+{
+    InfoXml info_xml;
+    info_xml.type = "post";
+    info_xml.num = 4711;
+    info_xml.date = "2026-02-03 17:04:59";
+    info_xml.uid = 1000;
+    info_xml.pre_num = 4710;
+    info_xml.cleanup = "number";
+    info_xml.userdata = { { "important", "yes" }, { "empty", "" } };
+
+    check_round_trip(info_xml);
+}
+
+
+BOOST_AUTO_TEST_CASE(escaping)
+{
+    InfoXml info_xml;
+    info_xml.type = "pre";
+    info_xml.num = 12;
+    info_xml.date = "2026-02-03 17:04:59";
+    info_xml.description = "zypp(zypper) <&> \"quotes\" 'apostrophes'\r\n\ttab";
+    info_xml.cleanup = "timeline";
+    info_xml.userdata = { { "k\xc3\xa4y", "v\xe2\x82\xac\xf0\x9f\x98\x80" } };
+
+    check_round_trip(info_xml);
+}
+
+
+BOOST_AUTO_TEST_CASE(first_wins)
+{
+    InfoXml info_xml = read("<?xml version=\"1.0\"?>\n"
+			    "<snapshot>\n"
+			    "  <date>2026-01-14 08:15:32</date>\n"
+			    "  <num>5</num>\n"
+			    "  <num>6</num>\n"
+			    "  <type>single</type>\n"
+			    "  <unknown><num>7</num></unknown>\n"
+			    "  <userdata><key>a</key><value>1</value></userdata>\n"
+			    "  <userdata><key>a</key><value>2</value></userdata>\n"
+			    "  <userdata><value>3</value></userdata>\n"
+			    "  <userdata/>\n"
+			    "</snapshot>\n");
+
+    BOOST_CHECK_EQUAL(info_xml.type, "single");
+    BOOST_CHECK_EQUAL(info_xml.num, 5);
+    BOOST_CHECK_EQUAL(info_xml.date, "2026-01-14 08:15:32");
+    BOOST_CHECK_EQUAL(info_xml.userdata.size(), 1);
+    BOOST_CHECK_EQUAL(info_xml.userdata["a"], "2");
+}
+
+
+BOOST_AUTO_TEST_CASE(missing)
+{
+    InfoXml info_xml = read("<?xml version=\"1.0\"?>\n<snapshot>\n  <num>x</num>\n</snapshot>\n");
+
+    BOOST_CHECK(!info_xml.has_type);
+    BOOST_CHECK(info_xml.has_num);
+    BOOST_CHECK_EQUAL(info_xml.num, 0);
+    BOOST_CHECK(!info_xml.has_date);
+}
+
+
+BOOST_AUTO_TEST_CASE(malformed)
+{
+    BOOST_CHECK_THROW(read("<?xml version=\"1.0\"?>\n<snapshot>\n  <num>1</nom>\n</snapshot>\n"),
+		      IOErrorException);
+}
+
+
+BOOST_AUTO_TEST_CASE(checksum)
+{
+    char name[] = "/tmp/info-xml-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(name));
+
+    SDir info_dir(name);
+
+    InfoXml info_xml;
+    info_xml.type = "single";
+    info_xml.num = 42;
+    info_xml.date = "2026-03-01 12:00:00";
+
+    int fd = info_dir.open("info.xml", O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    info_xml.write(fd);
+
+    const string checksum = sha256_file(info_dir.fd(), "info.xml");
+    BOOST_CHECK_EQUAL(info_xml.checksum(), checksum);
+
+    // Without the checksum file the checksum is computed.
+
+    BOOST_CHECK_EQUAL(info_xml_checksum(info_dir), checksum);
+
+    // A checksum file is used as is.
+
+    const string fake(64, 'a');
+    write_info_xml_checksum(info_dir, fake);
+    BOOST_CHECK_EQUAL(info_xml_checksum(info_dir), fake);
+
+    // A checksum file older than info.xml is ignored.
+
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1, 0 } };
+    BOOST_REQUIRE(utimensat(info_dir.fd(), "info.xml.sha256", times, 0) == 0);
+    BOOST_CHECK_EQUAL(info_xml_checksum(info_dir), checksum);
+
+    // A malformed checksum file is ignored.
+
+    write_info_xml_checksum(info_dir, "not a checksum");
+    BOOST_CHECK_EQUAL(info_xml_checksum(info_dir), checksum);
+
+    remove_info_xml_checksum(info_dir);
+    remove_info_xml_checksum(info_dir);
+
+    BOOST_CHECK_EQUAL(info_dir.unlink("info.xml"), 0);
+    BOOST_CHECK_EQUAL(rmdir(name), 0);
+}
@@ -7,7 +7,7 @@
 #include <locale>
 
 #include <snapper/Exception.h>
-#include "../client/utils/Range.h"
+#include "../snapper/Range.h"
 
 using namespace std;
 using namespace snapper;
@@ -0,0 +1,71 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE sha256
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <boost/test/unit_test.hpp>
+
+#include "snapper/Sha256.h"
+#include "snapper/Exception.h"
+
+using namespace std;
+using namespace snapper;
+
+
+string
+sha256(const string& data)
+{
+    Sha256 sha256;
+    sha256.update(data);
+    return sha256.hex_digest();
+}
+
+
+BOOST_AUTO_TEST_CASE(test1)
+{
+    BOOST_CHECK_EQUAL(sha256(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    BOOST_CHECK_EQUAL(sha256("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    BOOST_CHECK_EQUAL(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+		      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+
+BOOST_AUTO_TEST_CASE(test2)
+{
+    // Feeding the data in pieces of different sizes must not change the
+    // result.
+
+    const string data(1000000, 'a');
+
+    BOOST_CHECK_EQUAL(sha256(data), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    for (size_t piece : { 1, 55, 56, 63, 64, 65, 4096 })
+    {
+	Sha256 sha256;
+	for (size_t pos = 0; pos < data.size(); pos += piece)
+	    sha256.update(data.substr(pos, piece));
+
+	BOOST_CHECK_EQUAL(sha256.hex_digest(), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test3)
+{
+    char name[] = "/tmp/sha256-XXXXXX";
+    int fd = mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+
+    BOOST_REQUIRE(write(fd, "abc", 3) == 3);
+    close(fd);
+
+    BOOST_CHECK_EQUAL(sha256_file(AT_FDCWD, name),
+		      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    unlink(name);
+
+    BOOST_CHECK_THROW(sha256_file(AT_FDCWD, name), IOErrorException);
+}
@@ -0,0 +1,165 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE stream_copy
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <boost/test/unit_test.hpp>
+
+#include "snapper/Sha256.h"
+#include "client/utils/StreamCopy.h"
+
+using namespace std;
+using namespace snapper;
+
+
+BOOST_AUTO_TEST_CASE(simple)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "head -c 3000000 /dev/zero" },
+			   { "/bin/sh", "-c", "wc -c" });
+    stream_copy.run();
+
+    BOOST_CHECK_EQUAL(stream_copy.get_source_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_progress().bytes, 3000000);
+
+    BOOST_REQUIRE_EQUAL(stream_copy.get_destination_output().size(), 1);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_output()[0], "3000000");
+}
+
+
+BOOST_AUTO_TEST_CASE(rate_limit)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "head -c 500000 /dev/zero" },
+			   { "/bin/sh", "-c", "cat > /dev/null" });
+    stream_copy.set_rate_limit(1000000);
+
+    unsigned int calls = 0;
+    stream_copy.set_progress_callback([&calls](const StreamCopy::Progress&) { ++calls; }, 0);
+
+    stream_copy.run();
+
+    BOOST_CHECK_EQUAL(stream_copy.get_progress().bytes, 500000);
+    BOOST_CHECK_GE(stream_copy.get_progress().seconds, 0.4);
+    BOOST_CHECK_GT(calls, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(source_fails)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "echo error >&2; exit 2" },
+			   { "/bin/sh", "-c", "cat > /dev/null" });
+    stream_copy.run();
+
+    BOOST_CHECK_EQUAL(stream_copy.get_source_retcode(), 2);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 0);
+
+    BOOST_REQUIRE_EQUAL(stream_copy.get_source_output().size(), 1);
+    BOOST_CHECK_EQUAL(stream_copy.get_source_output()[0], "error");
+}
+
+
+BOOST_AUTO_TEST_CASE(destination_fails)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "exec head -c 100000000 /dev/zero" },
+			   { "/bin/sh", "-c", "exit 3" });
+    stream_copy.run();
+
+    BOOST_CHECK_NE(stream_copy.get_source_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(not_found)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "echo data" },
+			   { "/does/not/exist" });
+    stream_copy.run();
+
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 127);
+}
+
+
+BOOST_AUTO_TEST_CASE(filter)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "head -c 3000000 /dev/zero" },
+			   { "/bin/sh", "-c", "gzip -d -c | wc -c" });
+    stream_copy.set_filter({ "gzip", "-c" });
+    stream_copy.run();
+
+    BOOST_CHECK_EQUAL(stream_copy.get_source_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_filter_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 0);
+
+    BOOST_CHECK_EQUAL(stream_copy.get_progress().bytes, 3000000);
+    BOOST_CHECK_LT(stream_copy.get_progress().destination_bytes, 100000);
+
+    BOOST_REQUIRE_EQUAL(stream_copy.get_destination_output().size(), 1);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_output()[0], "3000000");
+}
+
+
+BOOST_AUTO_TEST_CASE(filter_fails)
+{
+    StreamCopy stream_copy({ "/bin/sh", "-c", "exec head -c 100000000 /dev/zero" },
+			   { "/bin/sh", "-c", "cat > /dev/null" });
+    stream_copy.set_filter({ "/bin/sh", "-c", "head -c 1000" });
+    stream_copy.run();
+
+    BOOST_CHECK_NE(stream_copy.get_source_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_filter_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_destination_retcode(), 0);
+    BOOST_CHECK_EQUAL(stream_copy.get_progress().destination_bytes, 1000);
+}
+
+
+BOOST_AUTO_TEST_CASE(resume)
+{
+    char tmp_dir[] = "/tmp/stream-copy-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmp_dir));
+
+    const string file = string(tmp_dir) + "/stream";
+
+    // The receiver is killed after writing part of the stream.
+
+    StreamCopy stream_copy1({ "/bin/sh", "-c", "seq 1 200000" },
+			    { "/bin/sh", "-c", "head -c 300000 >> \"$1\"; kill -9 $$", "sh", file });
+    stream_copy1.run();
+
+    BOOST_CHECK_NE(stream_copy1.get_destination_retcode(), 0);
+
+    int dirfd = open(tmp_dir, O_RDONLY | O_DIRECTORY);
+    BOOST_REQUIRE(dirfd >= 0);
+    const string digest = sha256_file(dirfd, "stream");
+
+    // Continuing with the correct digest completes the stream.
+
+    StreamCopy stream_copy2({ "/bin/sh", "-c", "seq 1 200000" },
+			    { "/bin/sh", "-c", "cat >> \"$1\"", "sh", file });
+    stream_copy2.set_skip(300000, digest);
+    stream_copy2.run();
+
+    BOOST_CHECK(stream_copy2.get_skip_matched());
+    BOOST_CHECK_EQUAL(stream_copy2.get_destination_retcode(), 0);
+
+    StreamCopy stream_copy3({ "/bin/sh", "-c", "seq 1 200000 | cmp - \"$1\"", "sh", file },
+			    { "/bin/sh", "-c", "cat > /dev/null" });
+    stream_copy3.run();
+
+    BOOST_CHECK_EQUAL(stream_copy3.get_source_retcode(), 0);
+
+    // Continuing with a wrong digest writes nothing.
+
+    StreamCopy stream_copy4({ "/bin/sh", "-c", "seq 1 200000" },
+			    { "/bin/sh", "-c", "wc -c" });
+    stream_copy4.set_skip(300000, string(64, '0'));
+    stream_copy4.run();
+
+    BOOST_CHECK(!stream_copy4.get_skip_matched());
+    BOOST_REQUIRE_EQUAL(stream_copy4.get_destination_output().size(), 1);
+    BOOST_CHECK_EQUAL(stream_copy4.get_destination_output()[0], "0");
+
+    close(dirfd);
+    unlink(file.c_str());
+    rmdir(tmp_dir);
+}
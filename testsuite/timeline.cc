@@ -0,0 +1,139 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE timeline
+
+#include <string.h>
+#include <functional>
+#include <random>
+#include <boost/test/unit_test.hpp>
+
+#include "../snapper/timeline.h"
+#include "../snapper/equal-date.h"
+
+using namespace std;
+using namespace snapper;
+
+
+// The selection as done by TimelineCleaner before timeline_keep() was
+// introduced.
+
+bool
+is_first(const vector<TimelineEntry>& entries, size_t i,
+	 std::function<bool(const struct tm& tmp1, const struct tm& tmp2)> pred)
+{
+    for (size_t j = i + 1; j < entries.size(); ++j)
+    {
+	if (!pred(entries[i].tm, entries[j].tm))
+	    return true;
+
+	if (entries[i].date > entries[j].date)
+	    return false;
+    }
+
+    return true;
+}
+
+
+vector<bool>
+reference(const vector<TimelineEntry>& entries, const TimelineLimits& limits)
+{
+    vector<bool> keep(entries.size(), false);
+
+    size_t num_hourly = 0;
+    size_t num_daily = 0;
+    size_t num_weekly = 0;
+    size_t num_monthly = 0;
+    size_t num_quarterly = 0;
+    size_t num_yearly = 0;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+	if (num_hourly < limits.hourly && is_first(entries, i, equal_hour))
+	    ++num_hourly, keep[i] = true;
+	if (num_daily < limits.daily && is_first(entries, i, equal_day))
+	    ++num_daily, keep[i] = true;
+	if (num_weekly < limits.weekly && is_first(entries, i, equal_week))
+	    ++num_weekly, keep[i] = true;
+	if (num_monthly < limits.monthly && is_first(entries, i, equal_month))
+	    ++num_monthly, keep[i] = true;
+	if (num_quarterly < limits.quarterly && is_first(entries, i, equal_quarter))
+	    ++num_quarterly, keep[i] = true;
+	if (num_yearly < limits.yearly && is_first(entries, i, equal_year))
+	    ++num_yearly, keep[i] = true;
+    }
+
+    return keep;
+}
+
+
+TimelineEntry
+entry(time_t date)
+{
+    TimelineEntry entry;
+    entry.date = date;
+    memset(&entry.tm, 0, sizeof(entry.tm));
+    gmtime_r(&date, &entry.tm);
+    return entry;
+}
+
+
+BOOST_AUTO_TEST_CASE(hourly)
+{
+    // newest first, three snapshots per hour
+
+    vector<TimelineEntry> entries;
+    for (time_t t = 1700000000 + 10 * 3600; t > 1700000000; t -= 1200)
+	entries.push_back(entry(t));
+
+    TimelineLimits limits;
+    limits.hourly = 4;
+
+    vector<bool> keep = timeline_keep(entries, limits);
+
+    BOOST_CHECK(keep == reference(entries, limits));
+    BOOST_CHECK_EQUAL(count(keep.begin(), keep.end(), true), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(no_entries)
+{
+    TimelineLimits limits;
+    limits.yearly = 10;
+
+    BOOST_CHECK(timeline_keep({}, limits).empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(compare_with_reference)
+{
+    mt19937 gen(42);
+
+    for (int round = 0; round < 200; ++round)
+    {
+	// mostly newest first but with some dates out of order
+
+	vector<TimelineEntry> entries;
+
+	time_t t = 1700000000;
+	uniform_int_distribution<int> num_dist(0, 400);
+	uniform_int_distribution<time_t> step_dist(0, 3 * 86400);
+	uniform_int_distribution<int> disorder_dist(0, 9);
+
+	for (int i = num_dist(gen); i > 0; --i)
+	{
+	    t -= step_dist(gen);
+	    entries.push_back(entry(disorder_dist(gen) == 0 ? t + step_dist(gen) : t));
+	}
+
+	uniform_int_distribution<size_t> limit_dist(0, 12);
+
+	TimelineLimits limits;
+	limits.hourly = limit_dist(gen);
+	limits.daily = limit_dist(gen);
+	limits.weekly = limit_dist(gen);
+	limits.monthly = limit_dist(gen);
+	limits.quarterly = limit_dist(gen);
+	limits.yearly = limit_dist(gen);
+
+	BOOST_CHECK(timeline_keep(entries, limits) == reference(entries, limits));
+    }
+}